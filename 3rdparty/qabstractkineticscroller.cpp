@@ -48,6 +48,7 @@
 #include <QCoreApplication>
 #include <QMouseEvent>
 #include <QGraphicsSceneMouseEvent>
+#include <qmath.h>
 
 #include <QtDebug>
 
@@ -152,9 +153,7 @@ void QAbstractKineticScroller::reset()
     Q_D(QAbstractKineticScroller);
 
     d->changeState(Inactive);
-    if (d->idleTimerId)
-        d->killTimer(d->idleTimerId);
-    d->idleTimerId = 0;
+    d->stopIdleTimer();
     if (d->scrollTimerId)
         d->killTimer(d->scrollTimerId);
     d->scrollTimerId = 0;
@@ -290,7 +289,7 @@ QAbstractKineticScrollerPrivate::QAbstractKineticScrollerPrivate()
     scrollTo(-1, -1), bounceSteps(3), maxOvershoot(150, 150), vmaxOvershoot(130),
     overshootDist(0, 0), overshooting(0),
     minVelocity(10), maxVelocity(3500), fastVelocityFactor(0.01), deceleration(0.85),
-    scrollsPerSecond(20), panningThreshold(25), directionErrorMargin(10),
+    scrollsPerSecond(20), motionUpdatesPerSecond(MotionEventsPerSecond), panningThreshold(25), directionErrorMargin(10),
     dragInertia(0.85), scrollTime(1000), axisLockThreshold(0),
     idleTimerId(0), scrollTimerId(0)
 { }
@@ -323,25 +322,58 @@ void QAbstractKineticScrollerPrivate::handleScrollTimer()
     scrollTimerId = 0;
 }
 
+void QAbstractKineticScrollerPrivate::startIdleTimer()
+{
+    Q_Q(QAbstractKineticScroller);
+
+    if (idleTimerId)
+        return;
+    idleTime.start();
+    if (q->startFrameClock())
+        idleTimerId = ExternalIdleTimer;
+    else
+        idleTimerId = startTimer(1000 / scrollsPerSecond);
+}
+
+void QAbstractKineticScrollerPrivate::stopIdleTimer()
+{
+    Q_Q(QAbstractKineticScroller);
+
+    if (idleTimerId == ExternalIdleTimer)
+        q->stopFrameClock();
+    else if (idleTimerId)
+        killTimer(idleTimerId);
+    idleTimerId = 0;
+}
+
 void QAbstractKineticScrollerPrivate::handleIdleTimer()
 {
     Q_Q(QAbstractKineticScroller);
 
     if (mode == QAbstractKineticScroller::PushMode && overshootDist.isNull()) {
-        killTimer(idleTimerId);
-        idleTimerId = 0;
+        stopIdleTimer();
         changeState(QAbstractKineticScroller::Inactive);
         return;
     }
-    qKSDebug() << "idle timer - velocity: " << velocity << " overshoot: " << overshootDist;
 
-    setScrollPositionHelper(q->scrollPosition() - overshootDist - velocity.toPoint());
+    /* velocity and deceleration are per idle step (1/scrollsPerSecond).
+     * Advance by the number of steps that really elapsed so that a late
+     * tick keeps the trajectory instead of slowing the scroll down. Long
+     * stalls are capped so that we skip ahead instead of jumping.
+     */
+    qreal steps = qMin(idleTime.restart() * scrollsPerSecond / qreal(1000), qreal(MaximumIdleStepsPerTick));
+    if (steps <= 0)
+        return;
+
+    qKSDebug() << "idle timer - velocity: " << velocity << " overshoot: " << overshootDist << " steps: " << steps;
+
+    setScrollPositionHelper(q->scrollPosition() - overshootDist - (velocity * steps).toPoint());
 
     if (!overshootDist.isNull()) {
         if (moved)
             return;
 
-        overshooting++;
+        overshooting += steps;
         scrollTo = QPoint(-1, -1);
 
         /* When the overshoot has started we continue for
@@ -355,8 +387,10 @@ void QAbstractKineticScrollerPrivate::handleIdleTimer()
             velocity.setX( overshootDist.x() / maxOvershoot.x() * velocity.x() );
             velocity.setY( overshootDist.y() / maxOvershoot.y() * velocity.y() );
         } else {
-            velocity.setX( -overshootDist.x() * 0.8 );
-            velocity.setY( -overshootDist.y() * 0.8 );
+            // return 80% of the remaining overshoot per step
+            qreal returned = (1 - qPow(qreal(0.2), steps)) / steps;
+            velocity.setX( -overshootDist.x() * returned );
+            velocity.setY( -overshootDist.y() * returned );
 
             // ensure a minimum speed when scrolling back or else we might never return
             if (velocity.x() > -1.0 && velocity.x() < 0.0)
@@ -407,34 +441,33 @@ void QAbstractKineticScrollerPrivate::handleIdleTimer()
             */
 
             if (velocity.x() == 0.0 && velocity.y() == 0.0) {
-                killTimer(idleTimerId);
-                idleTimerId = 0;
+                stopIdleTimer();
                 changeState(QAbstractKineticScroller::Inactive);
                 return;
             }
 
             // -- don't get too slow if target was not yet reached
+            qreal stepDeceleration = qPow(deceleration, steps);
             if (qAbs(velocity.x()) >= qreal(1.5))
-                velocity.rx() *= deceleration;
+                velocity.rx() *= stepDeceleration;
             if (qAbs(velocity.y()) >= qreal(1.5))
-                velocity.ry() *= deceleration;
+                velocity.ry() *= stepDeceleration;
 
         } else {
+            qreal stepDeceleration = qPow(deceleration, steps);
             if (!lowFrictionMode || (qAbs(velocity.x()) < qreal(0.8) * maxVelocity))
-                velocity.rx() *= deceleration;
+                velocity.rx() *= stepDeceleration;
             if (!lowFrictionMode || (qAbs(velocity.y()) < qreal(0.8) * maxVelocity))
-                velocity.ry() *= deceleration;
+                velocity.ry() *= stepDeceleration;
 
             if ((qAbs(velocity.x()) < qreal(1.0)) && (qAbs(velocity.y()) < qreal(1.0))) {
                 velocity = QPointF(0, 0);
-                killTimer(idleTimerId);
-                idleTimerId = 0;
+                stopIdleTimer();
                 changeState(QAbstractKineticScroller::Inactive);
             }
         }
     } else if (mode == QAbstractKineticScroller::AutoMode) {
-        killTimer(idleTimerId);
-        idleTimerId = 0;
+        stopIdleTimer();
         changeState(QAbstractKineticScroller::Inactive);
     }
 }
@@ -474,8 +507,7 @@ bool QAbstractKineticScrollerPrivate::handleMousePress(QMouseEvent *e)
     velocity = QPointF(0, 0);
 
     if (idleTimerId) {
-        killTimer(idleTimerId);
-        idleTimerId = 0;
+        stopIdleTimer();
         changeState(QAbstractKineticScroller::Inactive);
     }
 
@@ -630,7 +662,7 @@ bool QAbstractKineticScrollerPrivate::handleMouseRelease(QMouseEvent *e)
                 || (qAbs(velocity.y()) >= minVelocity)
                 || overshootDist.x()
                 || overshootDist.y()) ) {
-        idleTimerId = startTimer(1000 / scrollsPerSecond);
+        startIdleTimer();
     }
 
     lastTime.restart();
@@ -676,7 +708,7 @@ void QAbstractKineticScrollerPrivate::checkMove(QMouseEvent *me, QPoint &delta)
 
             if (!idleTimerId) {
                 changeState(QAbstractKineticScroller::AutoScrolling);
-                idleTimerId = startTimer(1000 / scrollsPerSecond);
+                startIdleTimer();
             }
         }
     }
@@ -781,13 +813,15 @@ void QAbstractKineticScrollerPrivate::scrollUpdate(const QPoint &delta)
 {
     Q_Q(QAbstractKineticScroller);
 
-    if (scrollTimerId) {
+    if (!motionUpdatesPerSecond) {
+        setScrollPositionHelper(q->scrollPosition() - overshootDist - delta);
+    } else if (scrollTimerId) {
         motion += delta;
     } else {
         // we do not delay the first event but the next ones
         setScrollPositionHelper(q->scrollPosition() - overshootDist - delta);
         motion = QPoint(0, 0);
-        scrollTimerId = startTimer(1000 / MotionEventsPerSecond);
+        scrollTimerId = startTimer(1000 / motionUpdatesPerSecond);
     }
 }
 
@@ -1140,6 +1174,33 @@ void QAbstractKineticScroller::setScrollsPerSecond(int sps)
     d->scrollsPerSecond = qBound(1, sps, 100);
 }
 
+/*!
+    Returns the maximum number of scroll position updates per second while
+    the user is dragging. Mouse moves arriving faster are accumulated.
+
+    The default value is \c 25.
+
+    \sa setMotionUpdatesPerSecond()
+*/
+int QAbstractKineticScroller::motionUpdatesPerSecond() const
+{
+    Q_D(const QAbstractKineticScroller);
+    return d->motionUpdatesPerSecond;
+}
+
+/*!
+    Sets the maximum number of scroll position updates per second while
+    dragging to \a mps. A value of 0 applies every mouse move immediately,
+    which is useful when the mouse moves are already coalesced per frame.
+
+    \sa motionUpdatesPerSecond()
+*/
+void QAbstractKineticScroller::setMotionUpdatesPerSecond(int mps)
+{
+    Q_D(QAbstractKineticScroller);
+    d->motionUpdatesPerSecond = qBound(0, mps, 100);
+}
+
 
 /*!
     Starts scrolling the widget so that the point \a pos is visible inside
@@ -1185,7 +1246,7 @@ void QAbstractKineticScroller::scrollTo(const QPoint &pos)
 
     if (!d->idleTimerId) {
         d->changeState(QAbstractKineticScroller::AutoScrolling);
-        d->idleTimerId = d->startTimer(1000 / d->scrollsPerSecond);
+        d->startIdleTimer();
     }
 }
 
@@ -1321,6 +1382,45 @@ void QAbstractKineticScroller::stateChanged(State oldState, State newState)
     Q_UNUSED(newState);
 }
 
+/*!
+    This function gets called when the scroller starts auto scrolling or
+    overshooting. Subclasses that return true drive the scroller themselves
+    by calling frameClockTick() once per displayed frame until
+    stopFrameClock() is called.
+
+    The default implementation returns false, and the scroller uses its own
+    timer ticking scrollsPerSecond() times per second.
+
+    \sa frameClockTick(), stopFrameClock()
+*/
+bool QAbstractKineticScroller::startFrameClock()
+{
+    return false;
+}
+
+/*!
+    This function gets called when the scroller no longer needs the frame
+    clock started by startFrameClock().
+
+    The default implementation does nothing.
+*/
+void QAbstractKineticScroller::stopFrameClock()
+{
+}
+
+/*!
+    Advances auto scrolling and overshooting to the current time. The motion
+    depends on the elapsed time only, so ticks may come late or be skipped.
+
+    \sa startFrameClock()
+*/
+void QAbstractKineticScroller::frameClockTick()
+{
+    Q_D(QAbstractKineticScroller);
+    if (d->idleTimerId == QAbstractKineticScrollerPrivate::ExternalIdleTimer)
+        d->handleIdleTimer();
+}
+
 /*!
     \fn QPoint QAbstractKineticScroller::maximumScrollPosition() const
 
@@ -123,6 +123,9 @@ public:
     int scrollsPerSecond() const;
     void setScrollsPerSecond(int sps);
 
+    int motionUpdatesPerSecond() const;
+    void setMotionUpdatesPerSecond(int mps);
+
     void scrollTo(const QPoint &pos);
     void ensureVisible(const QPoint &pos, int xmargin = 50, int ymargin = 50);
 
@@ -150,6 +153,10 @@ protected:
     virtual bool canStartScrollingAt(const QPoint &globalPos) const;
     virtual void cancelLeftMouseButtonPress(const QPoint &globalPressPos);
 
+    virtual bool startFrameClock();
+    virtual void stopFrameClock();
+    void frameClockTick();
+
     bool handleMouseEvent(QMouseEvent *e);
     bool handleMouseEvent(QGraphicsSceneMouseEvent *e);
 
@@ -80,6 +80,9 @@ public:
     void handleIdleTimer();
     void handleScrollTimer();
 
+    void startIdleTimer();
+    void stopIdleTimer();
+
 protected:
     void timerEvent(QTimerEvent *e);
 
@@ -101,6 +104,8 @@ private:
         CursorStoppedTimeout = 200, // ms
         MotionEventsPerSecond =  25,
         AccelFactor = 27,
+        ExternalIdleTimer = -1, // idleTimerId while driven by frameClockTick()
+        MaximumIdleStepsPerTick = 4
     };
 
     QAbstractKineticScroller *q_ptr;
@@ -129,7 +134,7 @@ private:
     QPoint maxOvershoot;
     int vmaxOvershoot;
     QPoint overshootDist;
-    int overshooting; // the overshooting time in idleTimer steps
+    qreal overshooting; // the overshooting time in idleTimer steps
 
     // velocity
     QPointF velocity;
@@ -140,6 +145,7 @@ private:
     qreal deceleration;
     QPointF accelerationVelocity;
     int scrollsPerSecond;
+    int motionUpdatesPerSecond;
     int panningThreshold;
     int directionErrorMargin;
     qreal dragInertia;
@@ -149,6 +155,7 @@ private:
     // timer
     int idleTimerId;
     int scrollTimerId;
+    QTime idleTime; // time since the last idle step
 };
 
 } // namespace YberHack_Qt
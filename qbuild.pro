@@ -30,32 +30,48 @@ HEADERS = \
   src/AutoSelectLineEdit.h \
   src/AutoSelectLineEdit_p.h \
   src/AutoScrollTest.h \
+  src/BackingStoreMetrics.h \
   src/BackingStoreVisualizerWidget.h \
   src/BookmarkStore.h \
+  src/BrowserTab.h \
   src/BrowsingView.h \
   src/CommonGestureRecognizer.h \
+  src/ContentFilter.h \
   src/CookieJar.h \
+  src/DiskCache.h \
   src/EnvHttpProxyFactory.h \
   src/EventHelpers.h \
   src/FontFactory.h \
+  src/FrameClock.h \
   src/Helpers.h \
   src/HistoryStore.h \
   src/HomeView.h \
+  src/InputResampler.h \
   src/KeypadWidget.h \
   src/LinkSelectionItem.h \
+  src/NetworkAccessManager.h \
+  src/NetworkTimingLog.h \
+  src/PageGeometryCache.h \
+  src/PageThrottle.h \
   src/PannableTileContainer.h \
   src/PannableViewport.h \
+  src/PerformanceReport.h \
   src/PopupView.h \
+  src/Preconnector.h \
+  src/Prefetcher.h \
   src/ProgressWidget.h \
   src/ScrollbarItem.h \
   src/Settings.h \
   src/TileContainerWidget.h \
   src/TileItem.h \
+  src/TileMemoryBudget.h \
   src/TileSelectionViewBase.h \
+  src/TileStoreTuner.h \
   src/ToolbarWidget.h \
   src/UrlItem.h \
   src/WebView.h \
   src/WebViewportItem.h \
+  src/WebViewPool.h \
   src/YberApplication.h \
   3rdparty/qabstractkineticscroller.h \
   3rdparty/qabstractkineticscroller_p.h \
@@ -65,31 +81,47 @@ HEADERS = \
 SOURCES = \
   src/AutoSelectLineEdit.cpp \
   src/AutoScrollTest.cpp \
+  src/BackingStoreMetrics.cpp \
   src/BackingStoreVisualizerWidget.cpp \
   src/BookmarkStore.cpp \
+  src/BrowserTab.cpp \
   src/BrowsingView.cpp \
   src/CommonGestureRecognizer.cpp \
+  src/ContentFilter.cpp \
   src/CookieJar.cpp \
+  src/DiskCache.cpp \
   src/EnvHttpProxyFactory.cpp\
   src/EventHelpers.cpp \
   src/FontFactory.cpp \
+  src/FrameClock.cpp \
   src/Helpers.cpp \
   src/HistoryStore.cpp \
   src/HomeView.cpp \
+  src/InputResampler.cpp \
   src/KeypadWidget.cpp \
   src/LinkSelectionItem.cpp \
+  src/NetworkAccessManager.cpp \
+  src/NetworkTimingLog.cpp \
+  src/PerformanceReport.cpp \
   src/PopupView.cpp \
+  src/Preconnector.cpp \
+  src/Prefetcher.cpp \
   src/ProgressWidget.cpp \
   src/ScrollbarItem.cpp \
   src/TileContainerWidget.cpp \
   src/TileItem.cpp \
+  src/TileMemoryBudget.cpp \
   src/TileSelectionViewBase.cpp \
+  src/TileStoreTuner.cpp \
   src/ToolbarWidget.cpp \
   src/UrlItem.cpp \
   src/WebView.cpp \
   src/WebViewportItem.cpp \
+  src/WebViewPool.cpp \
   src/YberApplication.cpp \
   src/main.cpp \
+  src/PageGeometryCache.cpp \
+  src/PageThrottle.cpp \
   src/PannableTileContainer.cpp \
   src/WebViewport.cpp \
   3rdparty/qabstractkineticscroller.cpp \
@@ -0,0 +1,85 @@
+#!/usr/bin/env python
+#
+# Local HTTP server for checking the disk cache.
+#
+# Serves a page that pulls in resources with different caching rules:
+#   /fresh/<n>    cacheable for an hour, should come from the cache
+#   /stale/<n>    must be revalidated, should get 304 with the stored copy
+#   /nostore/<n>  never stored
+#   /large        bigger than the cache takes
+# Every request is logged with its status. /stats shows the counts, so
+# loading the page twice, or after a restart of the browser, tells what
+# the cache did.
+#
+# usage: cache-test-server.py [port]
+#        yberbrowser http://localhost:8000/
+
+import sys
+
+try:
+    from http.server import BaseHTTPRequestHandler, HTTPServer
+except ImportError:
+    from BaseHTTPServer import BaseHTTPRequestHandler, HTTPServer
+
+RESOURCE_COUNT = 20
+LARGE_SIZE = 16 * 1024 * 1024
+LAST_MODIFIED = "Mon, 04 Oct 2010 12:00:00 GMT"
+
+stats = {}
+
+
+def count(key):
+    stats[key] = stats.get(key, 0) + 1
+
+
+class Handler(BaseHTTPRequestHandler):
+    def reply(self, status, body=b"", headers=()):
+        count("%s %s" % (self.path.split("/")[1] or "index", status))
+        self.send_response(status)
+        for name, value in headers:
+            self.send_header(name, value)
+        if status != 304:
+            self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        if status != 304:
+            self.wfile.write(body)
+
+    def do_GET(self):
+        parts = self.path.split("/")
+        kind = parts[1]
+        if kind == "":
+            links = []
+            for i in range(RESOURCE_COUNT):
+                for k in ("fresh", "stale", "nostore"):
+                    links.append('<img src="/%s/%d" width="8" height="8">' % (k, i))
+            links.append('<script src="/large"></script>')
+            body = ("<html><body><p><a href=\"/stats\">stats</a></p>%s</body></html>" % "".join(links)).encode()
+            self.reply(200, body, [("Content-Type", "text/html"), ("Cache-Control", "no-cache")])
+        elif kind == "fresh":
+            self.reply(200, self.resource(), [("Content-Type", "image/gif"), ("Cache-Control", "max-age=3600")])
+        elif kind == "stale":
+            etag = '"%s"' % parts[2]
+            if self.headers.get("If-None-Match") == etag or self.headers.get("If-Modified-Since") == LAST_MODIFIED:
+                self.reply(304, headers=[("ETag", etag)])
+            else:
+                self.reply(200, self.resource(), [("Content-Type", "image/gif"), ("Cache-Control", "max-age=0, must-revalidate"),
+                                                  ("ETag", etag), ("Last-Modified", LAST_MODIFIED)])
+        elif kind == "nostore":
+            self.reply(200, self.resource(), [("Content-Type", "image/gif"), ("Cache-Control", "no-store")])
+        elif kind == "large":
+            self.reply(200, b"//" + b"x" * LARGE_SIZE + b"\n", [("Content-Type", "text/javascript"), ("Cache-Control", "max-age=3600")])
+        elif kind == "stats":
+            body = "\n".join("%s: %d" % item for item in sorted(stats.items())).encode()
+            self.reply(200, body, [("Content-Type", "text/plain"), ("Cache-Control", "no-store")])
+        else:
+            self.reply(404)
+
+    def resource(self):
+        # smallest transparent gif
+        return b"GIF89a\x01\x00\x01\x00\x00\x00\x00!\xf9\x04\x01\x00\x00\x00\x00,\x00\x00\x00\x00\x01\x00\x01\x00\x00\x02\x00;"
+
+
+if __name__ == "__main__":
+    port = int(sys.argv[1]) if len(sys.argv) > 1 else 8000
+    print("serving on http://localhost:%d/" % port)
+    HTTPServer(("", port), Handler).serve_forever()
@@ -21,15 +21,21 @@
 #include "AutoScrollTest.h"
 #include "BrowsingView.h"
 #include "FontFactory.h"
+#include "FrameClock.h"
 #include "PannableViewport.h"
+#include "Settings.h"
 #include "WebViewport.h"
 #include "WebViewportItem.h"
 #include "WebView.h"
 
+#include <QApplication>
 #include <QGraphicsWidget>
 #include <QGraphicsScene>
 #include <QPainterPath>
 #include <QFontMetrics>
+#include <QGraphicsSceneMouseEvent>
+#include <QTouchEvent>
+#include <qmath.h>
 
 const int s_scrollPixels[] = {10, 20, 30, 40, 50, 10};
 const int s_scrollPixelsTimeot[] = {3000, 3000, 4000, 4000, 3000, 2000};
@@ -42,18 +48,39 @@ const QColor s_bckColor(20, 20, 20);
 const qreal s_bckTransparency = 0.9;
 const int s_fpsCheckTimeout = 100;
 const int s_scrollTimeout = 10;
+// uneven pointer event intervals, like a touch screen beating against the frame rate
+const int s_dragEventIntervals[] = {7, 19, 11, 23, 9, 15};
+const int s_dragTestDuration = 6000;
+const int s_dragPeriod = 1500;
+const qreal s_dragAmplitude = 150;
+// past the panning threshold
+const int s_dragMeasureStart = 300;
+const int s_pinchTestDuration = 3000;
+const int s_pinchEventInterval = 16;
+// distance of each finger from the pinch center, in px
+const qreal s_pinchMinSpread = 40;
+const qreal s_pinchMaxSpread = 160;
 
 AutoScrollTest::AutoScrollTest(PannableViewport* viewport, WebView* webView, QGraphicsItem* parent, Qt::WindowFlags wFlags)
     : QGraphicsWidget(parent, wFlags)
     , m_viewport(viewport)
     , m_webView(webView)
     , m_scrollTimer(this)
+    , m_dragTest(false)
+    , m_dragIndex(0)
+    , m_pinchTest(false)
+    , m_pinchStartScale(1)
+    , m_pinchPeakMagnification(1)
+    , m_pinchUpdates(0)
 {
     setFlag(QGraphicsItem::ItemClipsChildrenToShape, true);
     setFlag(QGraphicsItem::ItemClipsToShape, true);
 
     connect(&m_scrollTimer, SIGNAL(timeout()), this, SLOT(doScroll()));
     connect(&m_fpsTimer, SIGNAL(timeout()), this, SLOT(fpsTick()));
+    m_dragTimer.setSingleShot(true);
+    connect(&m_dragTimer, SIGNAL(timeout()), this, SLOT(doDrag()));
+    connect(&m_pinchTimer, SIGNAL(timeout()), this, SLOT(doPinch()));
 }
 
 AutoScrollTest::~AutoScrollTest()
@@ -78,6 +105,153 @@ void AutoScrollTest::starScrollTest()
     QTimer::singleShot(s_scrollPixelsTimeot[0], this, SLOT(scrollTimeout()));
 }
 
+/*! Drags the page up and down with synthesized mouse events sent to the
+  viewport at uneven intervals, and measures how closely the content
+  follows the finger at each frame. Run it with and without input
+  resampling (and prediction) to compare.
+*/
+void AutoScrollTest::startDragTest()
+{
+    m_dragTest = true;
+    if (m_webView->url().isEmpty()) {
+        m_webView->load(QUrl("http://news.google.com"));
+        connect(m_webView->page(), SIGNAL(loadFinished(bool)), this, SLOT(loadFinished(bool)));
+        return;
+    }
+
+    m_dragIndex = 0;
+    m_dragErrors.clear();
+    m_dragStartPos = m_viewport->mapToScene(m_viewport->rect().center());
+    m_dragPos = m_dragStartPos;
+    m_dragStartContentPos = m_viewport->position();
+
+    m_fpsTicks = m_webView->fpsTicks();
+    m_fpsTimestamp.start();
+    m_fpsTimer.start(s_fpsCheckTimeout);
+
+    sendDragEvent(QEvent::GraphicsSceneMousePress, m_dragPos);
+    m_dragTime.start();
+    m_dragTimer.start(s_dragEventIntervals[0]);
+    FrameClock::instance()->subscribe(this, SLOT(dragFrame()));
+}
+
+void AutoScrollTest::sendDragEvent(QEvent::Type type, const QPointF& scenePos)
+{
+    QGraphicsSceneMouseEvent event(type);
+    event.setScenePos(scenePos);
+    event.setPos(m_viewport->mapFromScene(scenePos));
+    event.setScreenPos(scenePos.toPoint());
+    event.setButton(type == QEvent::GraphicsSceneMouseMove ? Qt::NoButton : Qt::LeftButton);
+    event.setButtons(type == QEvent::GraphicsSceneMouseRelease ? Qt::NoButton : Qt::LeftButton);
+    m_viewport->scene()->sendEvent(m_viewport, &event);
+}
+
+void AutoScrollTest::doDrag()
+{
+    int elapsed = m_dragTime.elapsed();
+    if (elapsed >= s_dragTestDuration) {
+        FrameClock::instance()->unsubscribe(this, SLOT(dragFrame()));
+        sendDragEvent(QEvent::GraphicsSceneMouseRelease, m_dragPos);
+        m_fpsTimer.stop();
+        displayDragResult();
+        return;
+    }
+
+    // drag up first so that the page scrolls into its content
+    m_dragPos.setY(m_dragStartPos.y() - s_dragAmplitude * qSin(2 * M_PI * elapsed / s_dragPeriod));
+    sendDragEvent(QEvent::GraphicsSceneMouseMove, m_dragPos);
+
+    m_dragIndex = (m_dragIndex + 1) % (sizeof(s_dragEventIntervals) / sizeof(int));
+    m_dragTimer.start(s_dragEventIntervals[m_dragIndex]);
+}
+
+void AutoScrollTest::dragFrame()
+{
+    if (m_dragTime.elapsed() < s_dragMeasureStart)
+        return;
+    qreal contentMoved = m_viewport->position().y() - m_dragStartContentPos.y();
+    qreal fingerMoved = m_dragPos.y() - m_dragStartPos.y();
+    m_dragErrors.append(contentMoved - fingerMoved);
+}
+
+/*! Pinches the page open and closed again with synthesized two finger
+  touch events sent through the scene, like a touch screen would, and
+  measures the frame rate while the content follows the fingers.
+*/
+void AutoScrollTest::startPinchTest()
+{
+    m_pinchTest = true;
+    if (m_webView->url().isEmpty()) {
+        m_webView->load(QUrl("http://news.google.com"));
+        connect(m_webView->page(), SIGNAL(loadFinished(bool)), this, SLOT(loadFinished(bool)));
+        return;
+    }
+
+    m_pinchUpdates = 0;
+    m_pinchStartScale = m_webView->scale();
+    m_pinchPeakMagnification = 1;
+    m_pinchCenter = m_viewport->mapToScene(m_viewport->rect().center());
+
+    m_fpsTicks = m_webView->fpsTicks();
+    m_fpsTimestamp.start();
+    m_fpsTimer.start(s_fpsCheckTimeout);
+
+    sendPinchEvent(QEvent::TouchBegin, s_pinchMinSpread);
+    m_pinchTime.start();
+    m_pinchTimer.start(s_pinchEventInterval);
+}
+
+void AutoScrollTest::sendPinchEvent(QEvent::Type type, qreal spread)
+{
+    Qt::TouchPointState state = Qt::TouchPointMoved;
+    if (type == QEvent::TouchBegin)
+        state = Qt::TouchPointPressed;
+    else if (type == QEvent::TouchEnd)
+        state = Qt::TouchPointReleased;
+
+    QList<QTouchEvent::TouchPoint> points;
+    for (int i = 0; i < 2; ++i) {
+        QPointF scenePos = m_pinchCenter + QPointF(i ? spread : -spread, 0);
+        QTouchEvent::TouchPoint point(i);
+        point.setState(state);
+        point.setScenePos(scenePos);
+        point.setScreenPos(scenePos);
+        points.append(point);
+    }
+
+    QTouchEvent event(type, QTouchEvent::TouchScreen, Qt::NoModifier, state, points);
+    QApplication::sendEvent(m_viewport->scene(), &event);
+}
+
+void AutoScrollTest::doPinch()
+{
+    int elapsed = m_pinchTime.elapsed();
+    qreal spread = s_pinchMinSpread + (s_pinchMaxSpread - s_pinchMinSpread) * qSin(M_PI * qMin(elapsed, s_pinchTestDuration) / s_pinchTestDuration);
+
+    if (elapsed >= s_pinchTestDuration) {
+        m_pinchTimer.stop();
+        sendPinchEvent(QEvent::TouchEnd, spread);
+        m_fpsTimer.stop();
+        displayPinchResult();
+        return;
+    }
+
+    sendPinchEvent(QEvent::TouchUpdate, spread);
+    m_pinchUpdates++;
+    m_pinchPeakMagnification = qMax(m_pinchPeakMagnification, contentMagnification());
+}
+
+/*! The scale the viewport shows its content at on top of the scale the
+  web view has rendered it at.
+*/
+qreal AutoScrollTest::contentMagnification() const
+{
+    QGraphicsWidget* widget = m_viewport->widget();
+    if (!widget)
+        return 1;
+    return widget->transform().m11();
+}
+
 void AutoScrollTest::doScroll()
 {
     QPointF position(m_viewport->position().x(), m_viewport->position().y() - m_scrollValue);
@@ -103,7 +277,7 @@ void AutoScrollTest::loadFinished(bool success)
 {
     // dont start scrolling right after page is loaded. it alters the result
     if (success)
-        QTimer::singleShot(1000, this, SLOT(starScrollTest()));
+        QTimer::singleShot(1000, this, m_pinchTest ? SLOT(startPinchTest()) : m_dragTest ? SLOT(startDragTest()) : SLOT(starScrollTest()));
 }
 
 void AutoScrollTest::scrollTimeout()
@@ -243,3 +417,46 @@ void AutoScrollTest::displayResult()
     addTextItem(QRect(topRect.left() + 200, topRect.top(), 50, topRect.height()), QString("Avg:" + QString::number(m_avg) + "fps"));
 }
 
+void AutoScrollTest::displayDragResult()
+{
+    if (!m_dragErrors.size())
+        return;
+
+    displayResult();
+
+    // the panning threshold shifts the content by a constant, so only the
+    // spread of the error around its mean is lag and jitter
+    qreal mean = 0;
+    for (int i = 0; i < m_dragErrors.size(); ++i)
+        mean += m_dragErrors.at(i);
+    mean /= m_dragErrors.size();
+    qreal variance = 0;
+    for (int i = 0; i < m_dragErrors.size(); ++i)
+        variance += (m_dragErrors.at(i) - mean) * (m_dragErrors.at(i) - mean);
+    qreal trackingError = qSqrt(variance / m_dragErrors.size());
+
+    Settings* settings = Settings::instance();
+    QString mode = QString("resampling %1, prediction %2")
+        .arg(settings->inputResamplingEnabled() ? "on" : "off")
+        .arg(settings->inputPredictionEnabled() ? "on" : "off");
+
+    QRectF r(rect());
+    QRectF bottomRect(r.left() + r.width() / 10, r.bottom() - r.height() / 10 + 10, r.width() * 8 / 10, 20);
+    addTransparentRectangleItem(bottomRect);
+    addTextItem(bottomRect, QString("Tracking error: %1px (%2)").arg(trackingError, 0, 'f', 1).arg(mode));
+}
+
+void AutoScrollTest::displayPinchResult()
+{
+    displayResult();
+
+    // the web view scale only changes once the pinch has been committed
+    QRectF r(rect());
+    QRectF bottomRect(r.left() + r.width() / 10, r.bottom() - r.height() / 10 + 10, r.width() * 8 / 10, 20);
+    addTransparentRectangleItem(bottomRect);
+    addTextItem(bottomRect, QString("Pinch: %1 touch updates, peak magnification %2x, zoom %3 -> %4")
+                .arg(m_pinchUpdates)
+                .arg(m_pinchPeakMagnification, 0, 'f', 2)
+                .arg(m_pinchStartScale, 0, 'f', 2)
+                .arg(m_webView->scale(), 0, 'f', 2));
+}
@@ -26,6 +26,7 @@
 #include <QTime>
 #include <QTimer>
 #include <QPoint>
+#include <QEvent>
 
 class QGraphicsSceneMouseEvent;
 class PannableViewport;
@@ -41,7 +42,12 @@ public:
     void starScrollTest();
 
 public Q_SLOTS:
+    void startDragTest();
+    void startPinchTest();
     void doScroll();
+    void doDrag();
+    void dragFrame();
+    void doPinch();
     void fpsTick();
     void loadFinished(bool);
     void scrollTimeout();
@@ -56,6 +62,11 @@ private:
     void addTextItem(const QRectF&, const QString&);
     void addTransparentRectangleItem(const QRectF&);
     void displayResult();
+    void displayDragResult();
+    void displayPinchResult();
+    void sendDragEvent(QEvent::Type, const QPointF& scenePos);
+    void sendPinchEvent(QEvent::Type, qreal spread);
+    qreal contentMagnification() const;
     qreal getYValue(qreal fps);
 
 private:
@@ -71,5 +82,20 @@ private:
     int m_min;
     int m_max;
     int m_avg;
+    bool m_dragTest;
+    QTimer m_dragTimer;
+    QTime m_dragTime;
+    unsigned int m_dragIndex;
+    QPointF m_dragStartPos;
+    QPointF m_dragPos;
+    QPointF m_dragStartContentPos;
+    QList<qreal> m_dragErrors;
+    bool m_pinchTest;
+    QTimer m_pinchTimer;
+    QTime m_pinchTime;
+    QPointF m_pinchCenter;
+    qreal m_pinchStartScale;
+    qreal m_pinchPeakMagnification;
+    unsigned int m_pinchUpdates;
 };
 #endif
@@ -0,0 +1,436 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "BackingStoreMetrics.h"
+
+#if !USE_WEBKIT2
+
+#include <qgraphicswebview.h>
+#include <qwebpage.h>
+#include <qwebsettings.h>
+#include <QTextStream>
+#include <QTimer>
+
+//#define ENABLE_BACKING_STORE_METRICS_DEBUG
+
+namespace {
+// backing store pixmaps are 32bpp
+const int s_bytesPerTilePixel = 4;
+
+// upper bounds of the create-to-paint latency histogram buckets, the
+// last bucket holds everything slower
+const int s_latencyBucketLimitsMS[] = { 16, 33, 66, 133, 266, 533, 1066 };
+const int s_latencyBucketCount = sizeof(s_latencyBucketLimitsMS) / sizeof(s_latencyBucketLimitsMS[0]) + 1;
+
+// totals over all views of the session
+struct SessionTotals {
+    SessionTotals()
+        : frames(0), checkerboardedFrames(0), visibleArea(0), unpaintedArea(0), maxFrameCheckerboardRate(0)
+        , panFrames(0), panCheckerboardedFrames(0), panVisibleArea(0), panUnpaintedArea(0)
+        , tilesCreated(0), tilesFirstPainted(0), tileRepaints(0), latencySamples(0), latencySumMS(0), latencyMaxMS(0)
+        , tilesDiscardedUnshown(0), tilesDiscardedPaintedUnshown(0)
+    {
+        for (int i = 0; i < s_latencyBucketCount; ++i)
+            latencyBuckets[i] = 0;
+    }
+
+    int frames;
+    int checkerboardedFrames;
+    qreal visibleArea;
+    qreal unpaintedArea;
+    qreal maxFrameCheckerboardRate;
+    int panFrames;
+    int panCheckerboardedFrames;
+    qreal panVisibleArea;
+    qreal panUnpaintedArea;
+    int tilesCreated;
+    int tilesFirstPainted;
+    int tileRepaints;
+    int latencySamples;
+    qint64 latencySumMS;
+    int latencyMaxMS;
+    int latencyBuckets[s_latencyBucketCount];
+    int tilesDiscardedUnshown;
+    int tilesDiscardedPaintedUnshown;
+};
+
+SessionTotals s_session;
+
+qreal ratio(qreal part, qreal whole)
+{
+    return whole > 0 ? part / whole : 0;
+}
+}
+
+/*! \class BackingStoreMetrics keeps track of the tiles of a page's
+  tiled backing store and measures how they serve the frames drawn by
+  the view.
+
+  Tiles are kept in a flat grid indexed by their position, which is
+  cheap enough to consult for every painted frame. A frame sample
+  counts the exposed area that is not covered by a painted tile
+  (checkerboarding). Tile paint cost is estimated from the time between
+  consecutive backing store events of one update burst, as WebKit
+  creates and paints tiles back to back without returning to the event
+  loop.
+*/
+BackingStoreMetrics::BackingStoreMetrics(QGraphicsWebView* webView, QObject* parent)
+    : QObject(parent)
+    , m_webView(webView)
+    , m_page(0)
+    , m_columns(0)
+    , m_rows(0)
+    , m_liveTiles(0)
+    , m_tileScale(1.)
+    , m_inPaintBurst(false)
+    , m_lastBurstEventTime(0)
+    , m_panning(false)
+    , m_panFrames(0)
+    , m_panVisibleArea(0)
+    , m_panUnpaintedArea(0)
+    , m_sampleFrames(0)
+    , m_sampleVisibleArea(0)
+    , m_sampleUnpaintedArea(0)
+    , m_samplePaintCostMS(0)
+    , m_samplePaintCostCount(0)
+{
+    m_clock.start();
+}
+
+BackingStoreMetrics::~BackingStoreMetrics()
+{
+    detachFromPage();
+}
+
+void BackingStoreMetrics::attachToPage()
+{
+    detachFromPage();
+    m_page = m_webView->page();
+    if (!m_page)
+        return;
+
+    connect(m_page, SIGNAL(tileCreated(unsigned, unsigned)), this, SLOT(tileCreated(unsigned, unsigned)));
+    connect(m_page, SIGNAL(tileRemoved(unsigned, unsigned)), this, SLOT(tileRemoved(unsigned, unsigned)));
+    connect(m_page, SIGNAL(tilePainted(unsigned, unsigned)), this, SLOT(tilePainted(unsigned, unsigned)));
+    connect(m_page, SIGNAL(tileCacheViewportScaleChanged()), this, SLOT(tileCacheViewportScaleChanged()));
+    reset();
+}
+
+void BackingStoreMetrics::detachFromPage()
+{
+    if (!m_page)
+        return;
+    disconnect(m_page, 0, this, 0);
+    m_page = 0;
+}
+
+/*!
+  Forgets all tiles. Called when the backing store throws its tiles
+  away, i.e. on scale and tile size changes.
+*/
+void BackingStoreMetrics::reset()
+{
+    for (int i = 0; i < m_tiles.size(); ++i) {
+        if (m_tiles.at(i).live)
+            tileDiscarded(m_tiles.at(i));
+    }
+    m_tiles.clear();
+    m_columns = 0;
+    m_rows = 0;
+    m_liveTiles = 0;
+    updateTileGeometry();
+}
+
+void BackingStoreMetrics::updateTileGeometry()
+{
+    m_tileScale = m_webView->scale();
+    if (m_page)
+        m_tileSize = m_page->property("_q_TiledBackingStoreTileSize").toSize();
+}
+
+qint64 BackingStoreMetrics::tileMemoryBytes() const
+{
+    return qint64(m_liveTiles) * m_tileSize.width() * m_tileSize.height() * s_bytesPerTilePixel;
+}
+
+BackingStoreMetrics::TileRecord* BackingStoreMetrics::tileAt(unsigned hPos, unsigned vPos, bool create)
+{
+    int column = hPos;
+    int row = vPos;
+    if (column >= m_columns || row >= m_rows) {
+        if (!create)
+            return 0;
+        int columns = qMax(m_columns, column + 1);
+        int rows = qMax(m_rows, row + 1);
+        QVector<TileRecord> tiles(columns * rows);
+        for (int v = 0; v < m_rows; ++v)
+            for (int h = 0; h < m_columns; ++h)
+                tiles[v * columns + h] = m_tiles.at(v * m_columns + h);
+        m_tiles = tiles;
+        m_columns = columns;
+        m_rows = rows;
+    }
+    return &m_tiles[row * m_columns + column];
+}
+
+/*!
+  Returns the time in ms since the previous event of the current update
+  burst, or -1 if this event starts a new burst.
+*/
+int BackingStoreMetrics::backingStoreEvent()
+{
+    int now = m_clock.elapsed();
+    int sincePrevious = -1;
+    if (m_inPaintBurst) {
+        sincePrevious = now - m_lastBurstEventTime;
+    } else {
+        m_inPaintBurst = true;
+        QTimer::singleShot(0, this, SLOT(paintBurstEnded()));
+    }
+    m_lastBurstEventTime = now;
+    return sincePrevious;
+}
+
+void BackingStoreMetrics::paintBurstEnded()
+{
+    m_inPaintBurst = false;
+}
+
+void BackingStoreMetrics::tileDiscarded(const TileRecord& tile)
+{
+    if (tile.shown)
+        return;
+    s_session.tilesDiscardedUnshown++;
+    if (tile.painted)
+        s_session.tilesDiscardedPaintedUnshown++;
+}
+
+void BackingStoreMetrics::tileCreated(unsigned hPos, unsigned vPos)
+{
+    backingStoreEvent();
+    TileRecord* tile = tileAt(hPos, vPos, true);
+    if (tile->live)
+        tileDiscarded(*tile);
+    else
+        m_liveTiles++;
+    *tile = TileRecord();
+    tile->live = true;
+    tile->createdAt = m_clock.elapsed();
+    s_session.tilesCreated++;
+}
+
+void BackingStoreMetrics::tileRemoved(unsigned hPos, unsigned vPos)
+{
+    backingStoreEvent();
+    TileRecord* tile = tileAt(hPos, vPos, false);
+    if (!tile || !tile->live)
+        return;
+    tileDiscarded(*tile);
+    m_liveTiles--;
+    tile->live = false;
+    tile->painted = false;
+}
+
+void BackingStoreMetrics::tilePainted(unsigned hPos, unsigned vPos)
+{
+    int paintCost = backingStoreEvent();
+    TileRecord* tile = tileAt(hPos, vPos, true);
+    if (!tile->live) {
+        // painted without a creation we saw, a first paint with no latency to measure
+        m_liveTiles++;
+        tile->live = true;
+        s_session.tilesFirstPainted++;
+    } else if (!tile->paintCount) {
+        int latency = m_clock.elapsed() - tile->createdAt;
+        int bucket = 0;
+        while (bucket < s_latencyBucketCount - 1 && latency > s_latencyBucketLimitsMS[bucket])
+            ++bucket;
+        s_session.latencyBuckets[bucket]++;
+        s_session.latencySamples++;
+        s_session.latencySumMS += latency;
+        s_session.latencyMaxMS = qMax(s_session.latencyMaxMS, latency);
+        s_session.tilesFirstPainted++;
+    } else
+        s_session.tileRepaints++;
+    tile->painted = true;
+    tile->paintCount++;
+    if (paintCost >= 0) {
+        tile->lastPaintCostMS = paintCost;
+        m_samplePaintCostMS += paintCost;
+        m_samplePaintCostCount++;
+    }
+}
+
+void BackingStoreMetrics::tileCacheViewportScaleChanged()
+{
+    reset();
+}
+
+/*!
+  Records a frame drawn by the view. \a exposedRect is in view item
+  coordinates.
+*/
+void BackingStoreMetrics::frameRendered(const QRectF& exposedRect)
+{
+    if (!m_page || m_tileSize.isEmpty() || exposedRect.isEmpty())
+        return;
+    if (!m_webView->page()->settings()->testAttribute(QWebSettings::TiledBackingStoreEnabled))
+        return;
+
+    const QRectF visible(exposedRect.topLeft() * m_tileScale, exposedRect.size() * m_tileScale);
+    const int tileWidth = m_tileSize.width();
+    const int tileHeight = m_tileSize.height();
+    const int firstColumn = qMax(0, int(visible.left()) / tileWidth);
+    const int lastColumn = qMax(firstColumn, int(visible.right() - 1) / tileWidth);
+    const int firstRow = qMax(0, int(visible.top()) / tileHeight);
+    const int lastRow = qMax(firstRow, int(visible.bottom() - 1) / tileHeight);
+
+    qreal unpaintedArea = 0;
+    for (int v = firstRow; v <= lastRow; ++v) {
+        for (int h = firstColumn; h <= lastColumn; ++h) {
+            TileRecord* tile = tileAt(h, v, false);
+            if (tile && tile->live && tile->painted) {
+                tile->shown = true;
+                continue;
+            }
+            QRectF covered = visible & QRectF(h * tileWidth, v * tileHeight, tileWidth, tileHeight);
+            unpaintedArea += covered.width() * covered.height();
+        }
+    }
+
+    const qreal visibleArea = visible.width() * visible.height();
+    m_sampleFrames++;
+    m_sampleVisibleArea += visibleArea;
+    m_sampleUnpaintedArea += unpaintedArea;
+    if (m_panning) {
+        m_panFrames++;
+        m_panVisibleArea += visibleArea;
+        m_panUnpaintedArea += unpaintedArea;
+    }
+
+    s_session.frames++;
+    s_session.visibleArea += visibleArea;
+    s_session.unpaintedArea += unpaintedArea;
+    if (unpaintedArea > 0)
+        s_session.checkerboardedFrames++;
+    s_session.maxFrameCheckerboardRate = qMax(s_session.maxFrameCheckerboardRate, unpaintedArea / visibleArea);
+    if (m_panning) {
+        s_session.panFrames++;
+        s_session.panVisibleArea += visibleArea;
+        s_session.panUnpaintedArea += unpaintedArea;
+        if (unpaintedArea > 0)
+            s_session.panCheckerboardedFrames++;
+    }
+}
+
+/*!
+  Returns true if painted tiles cover all of \a rect, given in view
+  item coordinates.
+*/
+bool BackingStoreMetrics::isAreaPainted(const QRectF& rect) const
+{
+    if (m_tileSize.isEmpty() || rect.isEmpty())
+        return false;
+
+    const QRectF scaled(rect.topLeft() * m_tileScale, rect.size() * m_tileScale);
+    const int firstColumn = qMax(0, int(scaled.left()) / m_tileSize.width());
+    const int lastColumn = qMax(firstColumn, int(scaled.right() - 1) / m_tileSize.width());
+    const int firstRow = qMax(0, int(scaled.top()) / m_tileSize.height());
+    const int lastRow = qMax(firstRow, int(scaled.bottom() - 1) / m_tileSize.height());
+    if (lastColumn >= m_columns || lastRow >= m_rows)
+        return false;
+
+    for (int v = firstRow; v <= lastRow; ++v) {
+        for (int h = firstColumn; h <= lastColumn; ++h) {
+            const TileRecord& tile = m_tiles.at(v * m_columns + h);
+            if (!tile.live || !tile.painted)
+                return false;
+        }
+    }
+    return true;
+}
+
+/*!
+  Returns the share of visible area drawn without a painted tile in the
+  frames drawn while panning during the lifetime of the view.
+*/
+qreal BackingStoreMetrics::panCheckerboardRate() const
+{
+    return ratio(m_panUnpaintedArea, m_panVisibleArea);
+}
+
+/*!
+  Returns the statistics gathered since the previous call.
+*/
+BackingStoreMetrics::Sample BackingStoreMetrics::takeSample()
+{
+    Sample sample;
+    sample.frames = m_sampleFrames;
+    if (m_sampleVisibleArea > 0)
+        sample.checkerboardRate = m_sampleUnpaintedArea / m_sampleVisibleArea;
+    sample.paintCostSamples = m_samplePaintCostCount;
+    if (m_samplePaintCostCount)
+        sample.averagePaintCostMS = qreal(m_samplePaintCostMS) / m_samplePaintCostCount;
+    sample.liveTiles = m_liveTiles;
+    sample.tileMemoryBytes = tileMemoryBytes();
+
+#if defined(ENABLE_BACKING_STORE_METRICS_DEBUG)
+    qDebug() << __FUNCTION__ << "frames:" << sample.frames << "checkerboard:" << sample.checkerboardRate
+             << "paint cost:" << sample.averagePaintCostMS << "tiles:" << sample.liveTiles;
+#endif
+
+    m_sampleFrames = 0;
+    m_sampleVisibleArea = 0;
+    m_sampleUnpaintedArea = 0;
+    m_samplePaintCostMS = 0;
+    m_samplePaintCostCount = 0;
+    return sample;
+}
+
+/*!
+  Writes the backing store totals of all views of the session.
+*/
+void BackingStoreMetrics::writeSessionReport(QTextStream& stream)
+{
+    stream << "[backing store]" << endl;
+    stream << "frames: " << s_session.frames
+           << ", with checkerboarding: " << s_session.checkerboardedFrames << endl;
+    stream << "checkerboarded area: " << ratio(s_session.unpaintedArea, s_session.visibleArea) * 100 << "%"
+           << ", worst frame: " << s_session.maxFrameCheckerboardRate * 100 << "%" << endl;
+    stream << "pan frames: " << s_session.panFrames
+           << ", with checkerboarding: " << s_session.panCheckerboardedFrames
+           << ", checkerboarded area: " << ratio(s_session.panUnpaintedArea, s_session.panVisibleArea) * 100 << "%" << endl;
+    stream << "tiles created: " << s_session.tilesCreated
+           << ", painted: " << s_session.tilesFirstPainted
+           << ", repaints: " << s_session.tileRepaints << endl;
+    stream << "create to paint latency: average " << ratio(s_session.latencySumMS, s_session.latencySamples)
+           << "ms, max " << s_session.latencyMaxMS << "ms" << endl;
+    for (int i = 0; i < s_latencyBucketCount; ++i) {
+        if (i < s_latencyBucketCount - 1)
+            stream << "  <= " << s_latencyBucketLimitsMS[i] << "ms: ";
+        else
+            stream << "  > " << s_latencyBucketLimitsMS[i - 1] << "ms: ";
+        stream << s_session.latencyBuckets[i] << endl;
+    }
+    stream << "tiles discarded before shown: " << s_session.tilesDiscardedUnshown
+           << " (painted: " << s_session.tilesDiscardedPaintedUnshown << ")" << endl;
+}
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BackingStoreMetrics_h
+#define BackingStoreMetrics_h
+
+#if !USE_WEBKIT2
+#include <QObject>
+#include <QRectF>
+#include <QSize>
+#include <QTime>
+#include <QVector>
+#include "yberconfig.h"
+
+class QGraphicsWebView;
+class QTextStream;
+
+class BackingStoreMetrics : public QObject
+{
+    Q_OBJECT
+public:
+    struct Sample {
+        Sample() : frames(0), checkerboardRate(0), paintCostSamples(0), averagePaintCostMS(0), liveTiles(0), tileMemoryBytes(0) {}
+        int frames;
+        qreal checkerboardRate;
+        int paintCostSamples;
+        qreal averagePaintCostMS;
+        int liveTiles;
+        qint64 tileMemoryBytes;
+    };
+
+    struct TileRecord {
+        TileRecord() : live(false), painted(false), shown(false), createdAt(0), paintCount(0), lastPaintCostMS(0) {}
+        bool live;
+        bool painted;
+        bool shown;
+        int createdAt;
+        int paintCount;
+        int lastPaintCostMS;
+    };
+
+    BackingStoreMetrics(QGraphicsWebView*, QObject* parent = 0);
+    ~BackingStoreMetrics();
+
+    void attachToPage();
+    void detachFromPage();
+    void reset();
+
+    void frameRendered(const QRectF& exposedRect);
+    void setPanning(bool panning) { m_panning = panning; }
+    bool isPanning() const { return m_panning; }
+
+    int panFrameCount() const { return m_panFrames; }
+    qreal panCheckerboardRate() const;
+
+    // tile of column h and row v is at tiles()[v * columnCount() + h]
+    const QVector<TileRecord>& tiles() const { return m_tiles; }
+    int columnCount() const { return m_columns; }
+    QSize tileSize() const { return m_tileSize; }
+    qreal tileScale() const { return m_tileScale; }
+    int elapsed() const { return m_clock.elapsed(); }
+
+    bool isAreaPainted(const QRectF& rect) const;
+
+    int liveTileCount() const { return m_liveTiles; }
+    qint64 tileMemoryBytes() const;
+    Sample takeSample();
+
+    static void writeSessionReport(QTextStream&);
+
+protected Q_SLOTS:
+    void tileCreated(unsigned hPos, unsigned vPos);
+    void tileRemoved(unsigned hPos, unsigned vPos);
+    void tilePainted(unsigned hPos, unsigned vPos);
+    void tileCacheViewportScaleChanged();
+    void paintBurstEnded();
+
+private:
+    Q_DISABLE_COPY(BackingStoreMetrics)
+
+    TileRecord* tileAt(unsigned hPos, unsigned vPos, bool create);
+    void tileDiscarded(const TileRecord&);
+    void updateTileGeometry();
+    int backingStoreEvent();
+
+    QGraphicsWebView* m_webView;
+    QObject* m_page;
+
+    QVector<TileRecord> m_tiles;
+    int m_columns;
+    int m_rows;
+    int m_liveTiles;
+    QSize m_tileSize;
+    qreal m_tileScale;
+
+    QTime m_clock;
+    bool m_inPaintBurst;
+    int m_lastBurstEventTime;
+
+    bool m_panning;
+    int m_panFrames;
+    qreal m_panVisibleArea;
+    qreal m_panUnpaintedArea;
+
+    int m_sampleFrames;
+    qreal m_sampleVisibleArea;
+    qreal m_sampleUnpaintedArea;
+    int m_samplePaintCostMS;
+    int m_samplePaintCostCount;
+};
+#endif
+#endif
@@ -23,154 +23,174 @@
 #if !USE_WEBKIT2
 
 #include <qgraphicswebview.h>
-#include <QTimer>
-#include <QDebug>
-
-static const unsigned s_tileSize = 35;
-
-#define TILE_KEY(x,y) (x << 16 | y)
-
-class BackingStoreTileItem : public QObject {
-    Q_OBJECT
-public:
-    BackingStoreTileItem(unsigned hPos, unsigned vPos, QGraphicsItem* parent);
-    ~BackingStoreTileItem();
-
-    bool isActive() const;
-    void setActive(bool active);
-    void painted();
-
-private Q_SLOTS:
-    void paintBlinkEnd();
-
-private:
-    unsigned           m_vPos;
-    unsigned           m_hPos;
-    bool               m_active;
-    unsigned           m_beingPainted;
-    QGraphicsRectItem* m_rectItem;
-};
-
-BackingStoreTileItem::BackingStoreTileItem(unsigned hPos, unsigned vPos, QGraphicsItem* parent)
-    : m_vPos(vPos)
-    , m_hPos(hPos)
-    , m_active(false)
-    , m_beingPainted(0)
-    , m_rectItem(new QGraphicsRectItem(hPos*s_tileSize, vPos*s_tileSize, s_tileSize, s_tileSize, parent))
-{
-    setActive(true);
+#include <qwebpage.h>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QTimerEvent>
+
+namespace {
+// tiles reach the cold end of the scale at these values
+const int s_maxHeatAgeMS = 10000;
+const int s_maxHeatPaintCount = 10;
+const int s_maxHeatPaintCostMS = 30;
+const int s_ageUpdateIntervalMS = 1000;
+const qreal s_tileOpacity = .35;
 }
 
-BackingStoreTileItem::~BackingStoreTileItem()
+/*! \class BackingStoreVisualizerWidget draws the tiles of the backing
+  store on top of the web view as a heatmap.
+
+  The tile state comes from the flat tile grid of BackingStoreMetrics
+  and the whole grid is drawn in one paint pass, so the overlay only
+  costs anything while it exists. Tiles are coloured from red (hot) to
+  green (cold) by age, paint count or paint cost. Live tiles that have
+  not been painted yet are grey.
+*/
+BackingStoreVisualizerWidget::BackingStoreVisualizerWidget(QGraphicsWebView* webView, BackingStoreMetrics* metrics)
+    : QGraphicsWidget(webView)
+    , m_webView(webView)
+    , m_page(0)
+    , m_metrics(metrics)
+    , m_heatMode(HeatByAge)
 {
-    delete m_rectItem;
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+    setAcceptedMouseButtons(Qt::NoButton);
+    setAcceptHoverEvents(false);
+    resize(m_webView->size());
+    connect(m_webView, SIGNAL(geometryChanged()), this, SLOT(webViewGeometryChanged()));
+    attachToPage();
+    setHeatMode(HeatByAge);
 }
 
-bool BackingStoreTileItem::isActive() const
+BackingStoreVisualizerWidget::~BackingStoreVisualizerWidget()
 {
-    return m_active;
+    detachFromPage();
 }
 
-void BackingStoreTileItem::setActive(bool active)
+void BackingStoreVisualizerWidget::attachToPage()
 {
-    if (active && m_active)
-        qDebug() << "duplicate tile at:" << m_hPos << " " <<  m_vPos;
+    detachFromPage();
+    m_page = m_webView->page();
+    if (!m_page)
+        return;
 
-    m_active = active;
-    m_rectItem->setBrush(QBrush(active?Qt::cyan:Qt::gray));
-    m_rectItem->setOpacity(0.4);
+    connect(m_page, SIGNAL(tileCreated(unsigned, unsigned)), this, SLOT(backingStoreChanged()));
+    connect(m_page, SIGNAL(tileRemoved(unsigned, unsigned)), this, SLOT(backingStoreChanged()));
+    connect(m_page, SIGNAL(tilePainted(unsigned, unsigned)), this, SLOT(backingStoreChanged()));
+    connect(m_page, SIGNAL(tileCacheViewportScaleChanged()), this, SLOT(backingStoreChanged()));
+    update();
 }
 
-void BackingStoreTileItem::painted()
+void BackingStoreVisualizerWidget::detachFromPage()
 {
-    if (!m_rectItem->isVisible() || !m_active || m_beingPainted)
+    if (!m_page)
         return;
-    m_beingPainted = 1;
-    m_rectItem->setBrush(QBrush(Qt::red));
-    QTimer::singleShot(1000, this, SLOT(paintBlinkEnd()));
+    disconnect(m_page, 0, this, 0);
+    m_page = 0;
 }
 
-void BackingStoreTileItem::paintBlinkEnd()
+void BackingStoreVisualizerWidget::setHeatMode(HeatMode mode)
 {
-    // dont keep getting reinvalidated
-    if (m_beingPainted == 1) {
-        m_rectItem->setBrush(QBrush(m_active?Qt::cyan:Qt::gray));
-        QTimer::singleShot(1000, this, SLOT(paintBlinkEnd()));
-        m_beingPainted = 2;
-        return;
-    }
-    m_beingPainted = 0;
+    m_heatMode = mode;
+    // age changes without backing store activity
+    if (m_heatMode == HeatByAge)
+        m_ageUpdateTimer.start(s_ageUpdateIntervalMS, this);
+    else
+        m_ageUpdateTimer.stop();
+    update();
 }
 
-BackingStoreVisualizerWidget::BackingStoreVisualizerWidget(QGraphicsWebView* webView, QGraphicsItem* parent)
-    : QGraphicsWidget(parent)
-    , m_webView(webView)
+void BackingStoreVisualizerWidget::cycleHeatMode()
 {
-    connectSignals();
+    switch (m_heatMode) {
+    case HeatByAge:
+        setHeatMode(HeatByPaintCount);
+        break;
+    case HeatByPaintCount:
+        setHeatMode(HeatByPaintCost);
+        break;
+    case HeatByPaintCost:
+        setHeatMode(HeatByAge);
+        break;
+    }
 }
 
-BackingStoreVisualizerWidget::~BackingStoreVisualizerWidget()
+QString BackingStoreVisualizerWidget::heatModeName() const
 {
-    disconnectSignals();
-    resetCacheTiles();
-}
-
-
-void BackingStoreVisualizerWidget::connectSignals()
-{
-    connect(m_webView->page(),SIGNAL(tileCreated(unsigned, unsigned)), this, SLOT(tileCreated(unsigned, unsigned)));
-    connect(m_webView->page(),SIGNAL(tileRemoved(unsigned, unsigned)), this, SLOT(tileRemoved(unsigned, unsigned)));
-    connect(m_webView->page(),SIGNAL(tilePainted(unsigned, unsigned)), this, SLOT(tilePainted(unsigned, unsigned)));
-    connect(m_webView->page(),SIGNAL(tileCacheViewportScaleChanged()), this, SLOT(tileCacheViewportScaleChanged()));
+    switch (m_heatMode) {
+    case HeatByAge:
+        return "tile age";
+    case HeatByPaintCount:
+        return "tile paint count";
+    case HeatByPaintCost:
+        return "tile paint cost";
+    }
+    return QString();
 }
 
-void BackingStoreVisualizerWidget::disconnectSignals()
+void BackingStoreVisualizerWidget::timerEvent(QTimerEvent* ev)
 {
-    disconnect(m_webView->page(),SIGNAL(tileCreated(unsigned, unsigned)), this, SLOT(tileCreated(unsigned, unsigned)));
-    disconnect(m_webView->page(),SIGNAL(tileRemoved(unsigned, unsigned)), this, SLOT(tileRemoved(unsigned, unsigned)));
-    disconnect(m_webView->page(),SIGNAL(tilePainted(unsigned, unsigned)), this, SLOT(tilePainted(unsigned, unsigned)));
-    disconnect(m_webView->page(),SIGNAL(tileCacheViewportScaleChanged()), this, SLOT(tileCacheViewportScaleChanged()));
+    if (ev->timerId() == m_ageUpdateTimer.timerId()) {
+        update();
+        return;
+    }
+    QGraphicsWidget::timerEvent(ev);
 }
 
-
-void BackingStoreVisualizerWidget::tileCreated(unsigned hPos, unsigned vPos)
+void BackingStoreVisualizerWidget::backingStoreChanged()
 {
-    // new tile or just inactive?
-    if (!m_tileMap.contains(TILE_KEY(hPos, vPos)))
-        m_tileMap.insert(TILE_KEY(hPos, vPos), new BackingStoreTileItem(hPos, vPos, this));
-    else
-        m_tileMap.value(TILE_KEY(hPos, vPos))->setActive(true);
+    update();
 }
 
-void BackingStoreVisualizerWidget::tileRemoved(unsigned hPos, unsigned vPos)
+void BackingStoreVisualizerWidget::webViewGeometryChanged()
 {
-    if (!m_tileMap.contains(TILE_KEY(hPos, vPos)))
-        return;
-    m_tileMap.value(TILE_KEY(hPos, vPos))->setActive(false);
+    resize(m_webView->size());
 }
 
-void BackingStoreVisualizerWidget::tilePainted(unsigned hPos, unsigned vPos)
+QColor BackingStoreVisualizerWidget::tileColor(const BackingStoreMetrics::TileRecord& tile, int now) const
 {
-    if (!m_tileMap.contains(TILE_KEY(hPos, vPos)))
-        tileCreated(hPos, vPos);
-    m_tileMap.value(TILE_KEY(hPos, vPos))->painted();
+    if (!tile.painted)
+        return QColor(128, 128, 128, 255 * s_tileOpacity);
+
+    qreal heat = 0;
+    switch (m_heatMode) {
+    case HeatByAge:
+        heat = 1. - qMin(1., qreal(now - tile.createdAt) / s_maxHeatAgeMS);
+        break;
+    case HeatByPaintCount:
+        heat = qMin(1., qreal(tile.paintCount) / s_maxHeatPaintCount);
+        break;
+    case HeatByPaintCost:
+        heat = qMin(1., qreal(tile.lastPaintCostMS) / s_maxHeatPaintCostMS);
+        break;
+    }
+    // hue 0 (red) is hot, 1/3 (green) is cold
+    return QColor::fromHsvF((1. - heat) / 3., 1., 1., s_tileOpacity);
 }
 
-void BackingStoreVisualizerWidget::tileCacheViewportScaleChanged()
+void BackingStoreVisualizerWidget::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*)
 {
-    QTimer::singleShot(0, this, SLOT(resetCacheTiles()));
-}
+    const QVector<BackingStoreMetrics::TileRecord>& tiles = m_metrics->tiles();
+    const int columns = m_metrics->columnCount();
+    if (!columns || m_metrics->tileSize().isEmpty())
+        return;
 
-void BackingStoreVisualizerWidget::resetCacheTiles()
-{
-    QMapIterator<int, BackingStoreTileItem*> i(m_tileMap);
-    while (i.hasNext()) {
-        i.next();
-        delete i.value();
+    const QSizeF tileSize = QSizeF(m_metrics->tileSize()) / m_metrics->tileScale();
+    const int now = m_metrics->elapsed();
+
+    painter->save();
+    painter->setPen(QPen(Qt::black, 0));
+    for (int i = 0; i < tiles.size(); ++i) {
+        const BackingStoreMetrics::TileRecord& tile = tiles.at(i);
+        if (!tile.live)
+            continue;
+        QRectF tileRect(QPointF((i % columns) * tileSize.width(), (i / columns) * tileSize.height()), tileSize);
+        if (!tileRect.intersects(option->exposedRect))
+            continue;
+        painter->setBrush(tileColor(tile, now));
+        painter->drawRect(tileRect);
     }
-    m_tileMap.clear();
+    painter->restore();
 }
 
-#include "BackingStoreVisualizerWidget.moc"
-
 #endif
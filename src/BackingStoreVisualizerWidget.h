@@ -22,37 +22,54 @@
 #define BackingStoreVisualizerWidget_h
 
 #if !USE_WEBKIT2
+#include <QBasicTimer>
 #include <QGraphicsWidget>
-#include <QMap>
 #include "yberconfig.h"
+#include "BackingStoreMetrics.h"
 
 class QGraphicsWebView;
-class BackingStoreTileItem;
 
 class BackingStoreVisualizerWidget : public QGraphicsWidget
 {
     Q_OBJECT
 
 public:
-    BackingStoreVisualizerWidget(QGraphicsWebView*, QGraphicsItem* parent=0);
+    enum HeatMode {
+        HeatByAge,
+        HeatByPaintCount,
+        HeatByPaintCost
+    };
+
+    BackingStoreVisualizerWidget(QGraphicsWebView*, BackingStoreMetrics*);
     ~BackingStoreVisualizerWidget();
 
+    void attachToPage();
+    void detachFromPage();
+
+    void setHeatMode(HeatMode);
+    HeatMode heatMode() const { return m_heatMode; }
+    QString heatModeName() const;
+    void cycleHeatMode();
+
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget);
+
+protected:
+    void timerEvent(QTimerEvent*);
+
 protected Q_SLOTS:
-    void tileCreated(unsigned hPos, unsigned vPos);
-    void tileRemoved(unsigned hPos, unsigned vPos);
-    void tilePainted(unsigned hPos, unsigned vPos);
-    void tileCacheViewportScaleChanged();
-    void resetCacheTiles();
+    void backingStoreChanged();
+    void webViewGeometryChanged();
 
 private:
     Q_DISABLE_COPY(BackingStoreVisualizerWidget)
 
-    void connectSignals();
-    void disconnectSignals();
-    
-    QGraphicsWebView* m_webView;
-    QMap<int, BackingStoreTileItem*> m_tileMap;
+    QColor tileColor(const BackingStoreMetrics::TileRecord&, int now) const;
 
+    QGraphicsWebView* m_webView;
+    QObject* m_page;
+    BackingStoreMetrics* m_metrics;
+    HeatMode m_heatMode;
+    QBasicTimer m_ageUpdateTimer;
 };
 #endif
 #endif
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "BrowserTab.h"
+#include "WebView.h"
+#if !USE_WEBKIT2
+#include "BackingStoreMetrics.h"
+
+#include <qwebhistory.h>
+#include <qwebpage.h>
+#endif
+
+#include <QBuffer>
+#include <QDataStream>
+
+//#define ENABLE_TAB_HIBERNATION_DEBUG
+
+namespace {
+// DOM, JS heap and caches of a loaded page, which QtWebKit does not report
+const qint64 s_pageMemoryEstimateBytes = 8 * 1024 * 1024;
+}
+
+/*! \class BrowserTab one tab (window) of the browsing view.
+
+  A live tab owns its WebView. A hibernated tab has given up its WebView
+  and keeps only what is needed to bring the page back: the URL, the
+  serialized QWebHistory, the zoom scale and scroll position of the
+  viewport, and a thumbnail for the tab selection view.
+*/
+BrowserTab::BrowserTab(WebView* webView, QObject* parent)
+    : QObject(parent)
+    , m_webView(webView)
+    , m_zoomScale(0)
+    , m_viewportStateRestorePending(false)
+{
+}
+
+/*!
+  Creates a hibernated tab that loads \a url when it is restored.
+*/
+BrowserTab::BrowserTab(const QUrl& url, QObject* parent)
+    : QObject(parent)
+    , m_webView(0)
+    , m_url(url)
+    , m_zoomScale(0)
+    , m_viewportStateRestorePending(false)
+{
+}
+
+BrowserTab::~BrowserTab()
+{
+    delete m_webView;
+}
+
+QUrl BrowserTab::url() const
+{
+    // a restored page reports its URL once the load has committed
+    if (m_webView && !m_webView->url().isEmpty())
+        return m_webView->url();
+    return m_url;
+}
+
+QString BrowserTab::title() const
+{
+    if (m_webView && !m_webView->title().isEmpty())
+        return m_webView->title();
+    return m_title;
+}
+
+QImage BrowserTab::thumbnail() const
+{
+    QImage image;
+    if (!m_thumbnailData.isEmpty())
+        image.loadFromData(m_thumbnailData, "PNG");
+    return image;
+}
+
+qint64 BrowserTab::estimatedMemoryBytes() const
+{
+    if (!m_webView)
+        return 0;
+#if USE_WEBKIT2
+    return s_pageMemoryEstimateBytes;
+#else
+    return s_pageMemoryEstimateBytes + m_webView->backingStoreMetrics()->tileMemoryBytes();
+#endif
+}
+
+/*!
+  Remembers where the viewport was when the tab was last shown, in
+  contents coordinates. While a restore is pending the viewport does not
+  show the restored page yet, and the saved state is kept.
+*/
+void BrowserTab::setViewportState(qreal zoomScale, const QPointF& contentsPos)
+{
+    if (m_viewportStateRestorePending)
+        return;
+    m_zoomScale = zoomScale;
+    m_contentsPos = contentsPos;
+}
+
+/*!
+  Returns the viewport state to apply once a restored page has loaded,
+  only once after each restore.
+*/
+bool BrowserTab::takeRestoredViewportState(qreal& zoomScale, QPointF& contentsPos)
+{
+    if (!m_viewportStateRestorePending)
+        return false;
+    m_viewportStateRestorePending = false;
+    zoomScale = m_zoomScale;
+    contentsPos = m_contentsPos;
+    return m_zoomScale > 0;
+}
+
+/*!
+  Drops a pending restore of the viewport state, for a tab that is left
+  before its restored page has loaded. Its load finishing in the
+  background must not move the viewport of a later page.
+*/
+void BrowserTab::cancelViewportStateRestore()
+{
+    m_viewportStateRestorePending = false;
+}
+
+bool BrowserTab::canHibernate() const
+{
+#if USE_WEBKIT2
+    return false;
+#else
+    // nothing to bring back from an empty tab
+    return m_webView && !m_webView->url().isEmpty();
+#endif
+}
+
+/*!
+  Serializes the page state and destroys the WebView, together with the
+  page, its DOM, script heap and tiles.
+*/
+void BrowserTab::hibernate(const QImage& thumbnail)
+{
+    if (!canHibernate())
+        return;
+
+#if !USE_WEBKIT2
+#if defined(ENABLE_TAB_HIBERNATION_DEBUG)
+    qDebug() << __FUNCTION__ << m_webView->url() << estimatedMemoryBytes() / 1024 << "kB";
+#endif
+    m_url = m_webView->url();
+    m_title = m_webView->title();
+    m_thumbnailData.clear();
+    if (!thumbnail.isNull()) {
+        QBuffer buffer(&m_thumbnailData);
+        buffer.open(QIODevice::WriteOnly);
+        thumbnail.save(&buffer, "PNG");
+    }
+    m_history.clear();
+    QDataStream stream(&m_history, QIODevice::WriteOnly);
+    stream << *m_webView->page()->history();
+
+    // the page may be in the middle of emitting a signal
+    m_webView->hide();
+    m_webView->deleteLater();
+    m_webView = 0;
+#else
+    Q_UNUSED(thumbnail);
+#endif
+}
+
+/*!
+  Brings a hibernated tab back into \a webView. The history is restored,
+  which loads its current item, and the viewport state is handed out by
+  takeRestoredViewportState() for when that load finishes. Without a
+  history, as with WebKit2, the url of the tab is loaded.
+*/
+void BrowserTab::restore(WebView* webView)
+{
+    m_webView = webView;
+    bool hasHistory = false;
+#if !USE_WEBKIT2
+    if (!m_history.isEmpty()) {
+        QDataStream stream(&m_history, QIODevice::ReadOnly);
+        stream >> *m_webView->page()->history();
+    }
+    hasHistory = m_webView->page()->history()->count();
+#endif
+    if (!hasHistory && !m_url.isEmpty())
+        m_webView->load(m_url.toString());
+    m_history.clear();
+    m_thumbnailData.clear();
+    m_viewportStateRestorePending = true;
+}
+
+/*!
+  Writes what restoreState() needs to bring the tab back as a hibernated
+  tab, whether it is live or not.
+*/
+void BrowserTab::saveState(QDataStream& stream) const
+{
+    QByteArray history = m_history;
+#if !USE_WEBKIT2
+    if (m_webView) {
+        QDataStream historyStream(&history, QIODevice::WriteOnly);
+        historyStream << *m_webView->page()->history();
+    }
+#endif
+    stream << url() << title() << history << m_zoomScale << m_contentsPos << m_thumbnailData;
+}
+
+bool BrowserTab::restoreState(QDataStream& stream)
+{
+    Q_ASSERT(!m_webView);
+    stream >> m_url >> m_title >> m_history >> m_zoomScale >> m_contentsPos >> m_thumbnailData;
+    return stream.status() == QDataStream::Ok;
+}
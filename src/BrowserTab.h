@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BrowserTab_h
+#define BrowserTab_h
+
+#include "yberconfig.h"
+
+#include <QByteArray>
+#include <QImage>
+#include <QObject>
+#include <QPointF>
+#include <QString>
+#include <QUrl>
+
+class WebView;
+class QDataStream;
+
+class BrowserTab : public QObject
+{
+    Q_OBJECT
+public:
+    BrowserTab(WebView* webView, QObject* parent = 0);
+    BrowserTab(const QUrl& url, QObject* parent = 0);
+    ~BrowserTab();
+
+    WebView* webView() const { return m_webView; }
+    bool isHibernated() const { return !m_webView; }
+
+    QUrl url() const;
+    QString title() const;
+    QImage thumbnail() const;
+
+    qint64 estimatedMemoryBytes() const;
+
+    void setViewportState(qreal zoomScale, const QPointF& contentsPos);
+    bool takeRestoredViewportState(qreal& zoomScale, QPointF& contentsPos);
+    void cancelViewportStateRestore();
+
+    bool canHibernate() const;
+    void hibernate(const QImage& thumbnail);
+    void restore(WebView* webView);
+
+    void saveState(QDataStream&) const;
+    bool restoreState(QDataStream&);
+
+private:
+    Q_DISABLE_COPY(BrowserTab)
+
+    WebView* m_webView;
+    QUrl m_url;
+    QString m_title;
+    QByteArray m_history;
+    // PNG, decoded when the tab selection view asks for it
+    QByteArray m_thumbnailData;
+    qreal m_zoomScale;
+    QPointF m_contentsPos;
+    bool m_viewportStateRestorePending;
+};
+
+#endif
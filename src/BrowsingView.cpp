@@ -24,11 +24,12 @@
 #include <WebKit2/WKContext.h>
 #include <WebKit2/WKPageNamespace.h>
 #else
-#include "WebPage.h"
+#include "WebViewPool.h"
 #endif
 
 #include "WebViewportItem.h"
 #include "WebView.h"
+#include "BrowserTab.h"
 #include "ApplicationWindow.h"
 #include "Settings.h"
 #include "HomeView.h"
@@ -38,6 +39,15 @@
 #include "HistoryStore.h"
 #include "BookmarkStore.h"
 #include "AutoScrollTest.h"
+#include "PerformanceReport.h"
+#include "NetworkTimingLog.h"
+#include "YberApplication.h"
+#include "Preconnector.h"
+#if !USE_WEBKIT2
+#include "BackingStoreVisualizerWidget.h"
+#include "PageThrottle.h"
+#include "TileMemoryBudget.h"
+#endif
 #include "ToolbarWidget.h"
 #include "qwebframe.h"
 
@@ -47,6 +57,9 @@
 #include <QStyleOptionGraphicsItem>
 #include <QPainter>
 #include <QCoreApplication>
+#include <QDataStream>
+#include <QFile>
+#include <QTime>
 
 #if USE_MEEGOTOUCH
 #include <MTextEdit>
@@ -62,7 +75,16 @@
 
 namespace {
 
-const int s_maxWindows = 6;
+// hibernated tabs cost no more than their thumbnail, memory use is bounded
+// by the budget below rather than by the number of tabs
+const int s_maxWindows = 24;
+// background tabs are hibernated, least recently used first, once the
+// live ones are estimated to use more than this
+const qint64 s_liveWindowMemoryBudgetBytes = 40 * 1024 * 1024;
+// the active tab and the one used before it stay live regardless
+const int s_minLiveWindows = 2;
+const quint32 s_sessionVersion = 1;
+const int s_sessionSaveDelay = 2000;
 
 }
 
@@ -72,11 +94,13 @@ const int s_maxWindows = 6;
 BrowsingView::BrowsingView(QGraphicsItem *parent)
     : BrowsingViewBase(parent)
     , m_activeWebView(0)
+    , m_activeWindow(0)
     , m_autoScrollTest(0)
     , m_homeView(0)
     , m_initialHomeWidget(HomeView::VisitedPages)
     , m_toolbarWidget(new ToolbarWidget(this))
     , m_appWin(0)
+    , m_sessionStarted(false)
 {
     setFlag(QGraphicsItem::ItemClipsToShape, true);
     setFlag(QGraphicsItem::ItemClipsChildrenToShape, true);
@@ -92,14 +116,19 @@ BrowsingView::BrowsingView(QGraphicsItem *parent)
     connect(m_toolbarWidget, SIGNAL(sizeUpdated()), this, SLOT(updateToolbarSpacing()));
 #if USE_WEBKIT2
     m_context.adopt(WKContextGetSharedProcessContext());
+#else
+    m_webViewPool = new WebViewPool(this, this);
 #endif
 
-    // Create and activate new window.
-    newWindow();
+    m_sessionSaveTimer.setSingleShot(true);
+    connect(&m_sessionSaveTimer, SIGNAL(timeout()), this, SLOT(saveSession()));
+    // the windows are created by startSession()
 }
 
 BrowsingView::~BrowsingView()
 {
+    if (m_sessionSaveTimer.isActive())
+        saveSession();
     delete m_autoScrollTest;
     delete m_homeView;
     // FIXME: leaks the webviews
@@ -218,17 +247,53 @@ QMenuBar* BrowsingView::createMenu(QWidget* parent)
     developerMenu->addAction(fpsTestAction);
     connect(fpsTestAction, SIGNAL(triggered(bool)), this, SLOT(startAutoScrollTest()));
 
+    QAction* dragTestAction = new QAction("Drag test", this);
+    developerMenu->addAction(dragTestAction);
+    connect(dragTestAction, SIGNAL(triggered(bool)), this, SLOT(startDragTest()));
+
+    QAction* pinchTestAction = new QAction("Pinch test", this);
+    developerMenu->addAction(pinchTestAction);
+    connect(pinchTestAction, SIGNAL(triggered(bool)), this, SLOT(startPinchTest()));
+
+    QAction* inputResamplingAction = new QAction("Input resampling", this);
+    inputResamplingAction->setCheckable(true);
+    inputResamplingAction->setChecked(Settings::instance()->inputResamplingEnabled());
+    developerMenu->addAction(inputResamplingAction);
+    connect(inputResamplingAction, SIGNAL(toggled(bool)), this, SLOT(toggleInputResampling(bool)));
+
+    QAction* inputPredictionAction = new QAction("Input prediction", this);
+    inputPredictionAction->setCheckable(true);
+    inputPredictionAction->setChecked(Settings::instance()->inputPredictionEnabled());
+    developerMenu->addAction(inputPredictionAction);
+    connect(inputPredictionAction, SIGNAL(toggled(bool)), this, SLOT(toggleInputPrediction(bool)));
+
+    QAction* performanceReportAction = new QAction("Performance report", this);
+    developerMenu->addAction(performanceReportAction);
+    connect(performanceReportAction, SIGNAL(triggered(bool)), this, SLOT(writePerformanceReport()));
+
+    QAction* networkLogAction = new QAction("Export network log", this);
+    developerMenu->addAction(networkLogAction);
+    connect(networkLogAction, SIGNAL(triggered(bool)), this, SLOT(exportNetworkLog()));
+
+#if !USE_WEBKIT2
+    if (Settings::instance()->tileVisualizationEnabled()) {
+        QAction* tileHeatModeAction = new QAction("Tile heatmap mode", this);
+        developerMenu->addAction(tileHeatModeAction);
+        connect(tileHeatModeAction, SIGNAL(triggered(bool)), this, SLOT(cycleTileHeatMode()));
+    }
+#endif
+
     return menuBar;
 }
 #endif
 
-void BrowsingView::windowSelected(WebView* webView)
+void BrowsingView::windowSelected(BrowserTab* window)
 {
-    setActiveWindow(webView);
+    setActiveWindow(window);
     deleteHomeView();
 }
 
-void BrowsingView::windowClosed(WebView* webView)
+void BrowsingView::windowClosed(BrowserTab* window)
 {
     // Create a new window on last window destory. better idea?
     if (m_windowList.size() == 1) {
@@ -236,7 +301,7 @@ void BrowsingView::windowClosed(WebView* webView)
         deleteHomeView();
         newWindow();
     }
-    destroyWindow(webView);
+    destroyWindow(window);
 }
 
 void BrowsingView::windowCreated()
@@ -250,32 +315,58 @@ void BrowsingView::windowCreated()
     }
 }
 
-void BrowsingView::setActiveWindow(WebView* webView)
+void BrowsingView::setActiveWindow(BrowserTab* window)
 {
-    if (webView == m_activeWebView)
+    if (window == m_activeWindow)
         return;
+
+    if (m_activeWindow) {
+        m_activeWindow->setViewportState(m_browsingViewport->zoomScale(), m_browsingViewport->contentsPosition());
+        m_activeWindow->cancelViewportStateRestore();
+    }
+    if (window->isHibernated())
+        window->restore(createWebView());
+    WebView* webView = window->webView();
+
     // Invalidate address bar.
-    m_toolbarWidget->setTextIfUnfocused(webView->url().isEmpty() ? "No page loaded yet." : webView->url().toString());
+    m_toolbarWidget->setTextIfUnfocused(window->url().isEmpty() ? "No page loaded yet." : window->url().toString());
     connectWebViewSignals(webView, m_activeWebView);
-    if (m_activeWebView)
+    if (m_activeWebView) {
+#if !USE_WEBKIT2
+        m_activeWebView->pageThrottle()->setThrottled(true);
+#endif
         m_activeWebView->hide();
+    }
+#if !USE_WEBKIT2
+    webView->pageThrottle()->setThrottled(false);
+#endif
     webView->show();
     m_activeWebView = webView;
+    m_activeWindow = window;
     m_browsingViewport->setWebView(webView);
+#if !USE_WEBKIT2
+    TileMemoryBudget::instance()->activate(webView);
+#endif
+    m_recentWindows.removeOne(window);
+    m_recentWindows.prepend(window);
+    enforceWindowMemoryBudget();
+    saveSessionSoon();
 
     // View background needs to be updated.
     if (m_homeView)
         m_homeView->updateBackground(webviewSnapshot());
 }
 
-void BrowsingView::destroyWindow(WebView* webView)
+void BrowsingView::destroyWindow(BrowserTab* window)
 {
     for (int i = 0; i < m_windowList.size(); ++i) {
-        if (m_windowList.at(i) == webView) {
+        if (m_windowList.at(i) == window) {
             // current? activate the next one, unless this is the last window
-            if (webView == m_activeWebView)
+            if (window == m_activeWindow)
                 setActiveWindow(m_windowList.at((i == m_windowList.size() - 1) ? m_windowList.size() - 2 : i + 1));
+            m_recentWindows.removeOne(window);
             delete m_windowList.takeAt(i);
+            saveSessionSoon();
             break;
         }
     }
@@ -286,16 +377,161 @@ WebView* BrowsingView::newWindow()
     if (m_windowList.size() >= s_maxWindows)
         return 0;
 
+    QTime latency;
+    latency.start();
+    BrowserTab* window = new BrowserTab(createWebView());
+    m_windowList.append(window);
+    setActiveWindow(window);
+#if !USE_WEBKIT2
+    WebViewPool::newTabOpened(latency.elapsed());
+#endif
+    return window->webView();
+}
+
+/*!
+  Brings back the tabs of the previous session and opens \a urls in new
+  tabs, the first of them active. Only the active tab gets a WebView and
+  loads, the others stay hibernated until they are selected, so startup
+  does not slow down with the number of tabs.
+*/
+void BrowsingView::startSession(const QList<QUrl>& urls)
+{
+    int activeIndex = restoreSession();
+    QUrl activeWindowUrl;
+    for (int i = 0; i < urls.count(); ++i) {
+        if (m_windowList.size() >= s_maxWindows) {
+            // no room for a tab, the first url replaces the active page instead
+            if (!i)
+                activeWindowUrl = urls.at(i);
+            break;
+        }
+        m_windowList.append(new BrowserTab(urls.at(i)));
+        if (!i)
+            activeIndex = m_windowList.size() - 1;
+    }
+    m_sessionStarted = true;
+
+    if (activeIndex < 0 || activeIndex >= m_windowList.size()) {
+        // Create and activate new window.
+        newWindow();
+        return;
+    }
+    setActiveWindow(m_windowList.at(activeIndex));
+    if (!activeWindowUrl.isEmpty())
+        load(activeWindowUrl);
+}
+
+/*!
+  Reads the tabs of the previous session as hibernated tabs. Returns the
+  index of the tab that was active, or -1 if there was no session.
+*/
+int BrowsingView::restoreSession()
+{
+    QString path = Settings::instance()->sessionFilePath();
+    // a save that got cut off between replacing and renaming leaves only the new file
+    if (!QFile::exists(path))
+        path += ".tmp";
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return -1;
+
+    QDataStream stream(&file);
+    quint32 version;
+    qint32 activeIndex;
+    qint32 count;
+    stream >> version >> activeIndex >> count;
+    if (stream.status() != QDataStream::Ok || version != s_sessionVersion)
+        return -1;
+
+    for (int i = 0; i < count && i < s_maxWindows; ++i) {
+        BrowserTab* window = new BrowserTab(QUrl());
+        if (!window->restoreState(stream)) {
+            delete window;
+            break;
+        }
+        m_windowList.append(window);
+        // keep the order in which they were used before, roughly
+        if (i == activeIndex)
+            m_recentWindows.prepend(window);
+        else
+            m_recentWindows.append(window);
+    }
+    return activeIndex;
+}
+
+void BrowsingView::saveSessionSoon()
+{
+    if (m_sessionStarted)
+        m_sessionSaveTimer.start(s_sessionSaveDelay);
+}
+
+void BrowsingView::saveSession()
+{
+    m_sessionSaveTimer.stop();
+    if (m_activeWindow)
+        m_activeWindow->setViewportState(m_browsingViewport->zoomScale(), m_browsingViewport->contentsPosition());
+
+    // the previous session stays intact until the new one is written completely
+    QString path = Settings::instance()->sessionFilePath();
+    QFile file(path + ".tmp");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+
+    QDataStream stream(&file);
+    stream << s_sessionVersion << qint32(m_windowList.indexOf(m_activeWindow)) << qint32(m_windowList.size());
+    foreach (BrowserTab* window, m_windowList)
+        window->saveState(stream);
+    file.close();
+    if (stream.status() != QDataStream::Ok || file.error() != QFile::NoError) {
+        file.remove();
+        return;
+    }
+
+    // QFile::rename() does not replace an existing file
+    QFile::remove(path);
+    file.rename(path);
+}
+
+WebView* BrowsingView::createWebView()
+{
 #if USE_WEBKIT2
     WKRetainPtr<WKPageNamespaceRef> pageNamespace(AdoptWK, WKPageNamespaceCreate(m_context.get()));
-    WebView* webView = new WebView(pageNamespace.get());
+    return new WebView(pageNamespace.get());
 #else
-    WebView* webView = new WebView();
-    webView->setPage(new WebPage(webView, this));
+    return m_webViewPool->take();
 #endif
-    m_windowList.append(webView);
-    setActiveWindow(webView);
-    return webView;
+}
+
+/*!
+  Hibernates background tabs, least recently used first, until the
+  estimated memory use of the live tabs fits the budget. A hibernated
+  tab is restored when it is selected again.
+*/
+void BrowsingView::enforceWindowMemoryBudget()
+{
+    qint64 remaining = s_liveWindowMemoryBudgetBytes;
+    int liveWindows = 0;
+    foreach (BrowserTab* window, m_recentWindows) {
+        if (window->isHibernated())
+            continue;
+        qint64 bytes = window->estimatedMemoryBytes();
+        if (++liveWindows <= s_minLiveWindows || bytes <= remaining || !window->canHibernate()) {
+            remaining -= bytes;
+            continue;
+        }
+
+        // the tab selection view shows the same thumbnail the history has
+        QImage thumbnail;
+        const UrlList& list = HistoryStore::instance()->list();
+        for (int i = 0; i < list.size(); ++i) {
+            if (list.at(i).url() == window->url()) {
+                if (list.at(i).thumbnail())
+                    thumbnail = *list.at(i).thumbnail();
+                break;
+            }
+        }
+        window->hibernate(thumbnail);
+    }
 }
 
 void BrowsingView::createHomeView(HomeView::HomeWidgetType type)
@@ -310,12 +546,14 @@ void BrowsingView::createHomeView(HomeView::HomeWidgetType type)
     m_homeView = new HomeView(type, webviewSnapshot(), this);
     m_homeView->setWindowList(m_windowList);
     connect(m_homeView, SIGNAL(pageSelected(QUrl)), this, SLOT(load(QUrl)));
-    connect(m_homeView, SIGNAL(windowSelected(WebView*)), this, SLOT(windowSelected(WebView*)));
-    connect(m_homeView, SIGNAL(windowClosed(WebView*)), this, SLOT(windowClosed(WebView*)));
+    connect(m_homeView, SIGNAL(windowSelected(BrowserTab*)), this, SLOT(windowSelected(BrowserTab*)));
+    connect(m_homeView, SIGNAL(windowClosed(BrowserTab*)), this, SLOT(windowClosed(BrowserTab*)));
     connect(m_homeView, SIGNAL(windowCreated()), this, SLOT(windowCreated()));
     connect(m_homeView, SIGNAL(viewDismissed()), this, SLOT(deleteHomeView()));
     m_homeView->resize(QSize(3*size().width(), size().height()));
     m_homeView->appear();
+    // the user is about to pick a page
+    Preconnector::instance()->warmUpFrequentHostsSoon();
 }
 
 void BrowsingView::deleteHomeView()
@@ -380,6 +618,16 @@ void BrowsingView::loadFinished(bool success)
         urlChanged(m_activeWebView->url());
     }
     updateHistoryStore(success);
+
+    // a restored tab goes back to where it was left
+    qreal zoomScale;
+    QPointF contentsPos;
+    if (m_activeWindow->takeRestoredViewportState(zoomScale, contentsPos))
+        m_browsingViewport->setZoomScaleAndContentsPosition(zoomScale, contentsPos);
+
+    // the tiles of the page count against the budget too
+    enforceWindowMemoryBudget();
+    saveSessionSoon();
 }
 
 void BrowsingView::urlChanged(const QUrl& url)
@@ -445,6 +693,65 @@ void BrowsingView::finishedAutoScrollTest()
     m_autoScrollTest = 0;
 }
 
+void BrowsingView::startDragTest()
+{
+    if (Settings::instance()->isFullScreen() && !m_appWin->isFullScreen())
+        toggleFullScreen();
+    delete m_autoScrollTest;
+    m_autoScrollTest = new AutoScrollTest(m_browsingViewport, m_activeWebView, this);
+    m_autoScrollTest->resize(rect().size());
+    connect(m_autoScrollTest, SIGNAL(finished()), this, SLOT(finishedAutoScrollTest()));
+    m_autoScrollTest->startDragTest();
+}
+
+void BrowsingView::startPinchTest()
+{
+    if (Settings::instance()->isFullScreen() && !m_appWin->isFullScreen())
+        toggleFullScreen();
+    delete m_autoScrollTest;
+    m_autoScrollTest = new AutoScrollTest(m_browsingViewport, m_activeWebView, this);
+    m_autoScrollTest->resize(rect().size());
+    connect(m_autoScrollTest, SIGNAL(finished()), this, SLOT(finishedAutoScrollTest()));
+    m_autoScrollTest->startPinchTest();
+}
+
+void BrowsingView::toggleInputResampling(bool enable)
+{
+    Settings::instance()->enableInputResampling(enable);
+}
+
+void BrowsingView::toggleInputPrediction(bool enable)
+{
+    Settings::instance()->enableInputPrediction(enable);
+}
+
+void BrowsingView::writePerformanceReport()
+{
+    if (PerformanceReport::instance()->write())
+        notification("Report saved to " + PerformanceReport::instance()->filePath(), this);
+    else
+        notification("Could not save report.", this);
+}
+
+void BrowsingView::exportNetworkLog()
+{
+    QString filePath = Settings::instance()->networkLogFilePath();
+    if (YberApplication::instance()->networkAccessManager()->timingLog()->writeHar(filePath))
+        notification("Network log saved to " + filePath, this);
+    else
+        notification("Could not save network log.", this);
+}
+
+void BrowsingView::cycleTileHeatMode()
+{
+#if !USE_WEBKIT2
+    if (!m_activeWebView || !m_activeWebView->backingStoreVisualizer())
+        return;
+    m_activeWebView->backingStoreVisualizer()->cycleHeatMode();
+    notification("Tiles colored by " + m_activeWebView->backingStoreVisualizer()->heatModeName(), this);
+#endif
+}
+
 QGraphicsPixmapItem* BrowsingView::webviewSnapshot(bool darken)
 {
     QSizeF thumbnailSize(size());
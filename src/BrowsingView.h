@@ -26,6 +26,8 @@
 #include "HomeView.h"
 #include "ApplicationWindow.h"
 
+#include <QTimer>
+
 #if USE_WEBKIT2
 #define PLATFORM(x) 0
 #include <stdint.h>
@@ -49,6 +51,8 @@ class QMenuBar;
 typedef QMenuBar MenuBar;
 #endif
 
+class BrowserTab;
+class WebViewPool;
 class WebView;
 class WebViewportItem;
 class WebViewport;
@@ -71,14 +75,16 @@ public:
 #endif
     void createHomeView(HomeView::HomeWidgetType type);
 
+    void startSession(const QList<QUrl>& urls);
+
     void setAttachedWidget(QGraphicsItem*);
     void setOffsetWidget(QGraphicsItem*);
 
 public Q_SLOTS:
     void load(const QUrl&);
     WebView* newWindow();
-    void destroyWindow(WebView* webView);
-    void setActiveWindow(WebView* webView);
+    void destroyWindow(BrowserTab* window);
+    void setActiveWindow(BrowserTab* window);
 #if !USE_MEEGOTOUCH
     void setTitle(const QString&);
 #endif
@@ -104,19 +110,31 @@ protected Q_SLOTS:
 
     void startAutoScrollTest();
     void finishedAutoScrollTest();
-
-    void windowSelected(WebView* webView);
-    void windowClosed(WebView* webView);
+    void startDragTest();
+    void startPinchTest();
+    void toggleInputResampling(bool);
+    void toggleInputPrediction(bool);
+    void writePerformanceReport();
+    void exportNetworkLog();
+    void cycleTileHeatMode();
+
+    void windowSelected(BrowserTab* window);
+    void windowClosed(BrowserTab* window);
     void windowCreated();
     void deleteHomeView();
     void updateToolbarSpacingAndBrowsingViewportPosition();
 
     void webViewToolbarVisibleHint(bool);
+    void saveSession();
 
 private:
     Q_DISABLE_COPY(BrowsingView)
 
     void connectWebViewSignals(WebView* currentView, WebView* oldView);
+    WebView* createWebView();
+    void enforceWindowMemoryBudget();
+    int restoreSession();
+    void saveSessionSoon();
     void updateHistoryStore(bool successLoad);
     QGraphicsPixmapItem* webviewSnapshot(bool darken = true);
     
@@ -125,16 +143,23 @@ private:
 #endif
 
     WebView* m_activeWebView;
+    BrowserTab* m_activeWindow;
     WebViewport* m_browsingViewport;
     QSizeF m_sizeBeforeResize;
     AutoScrollTest* m_autoScrollTest;
-    QList<WebView*> m_windowList;
+    QList<BrowserTab*> m_windowList;
+    // most recently used first
+    QList<BrowserTab*> m_recentWindows;
     HomeView* m_homeView;
     HomeView::HomeWidgetType m_initialHomeWidget;
     ToolbarWidget* m_toolbarWidget;
     ApplicationWindow* m_appWin;
+    bool m_sessionStarted;
+    QTimer m_sessionSaveTimer;
 #if USE_WEBKIT2
     WKRetainPtr<WKContextRef> m_context;
+#else
+    WebViewPool* m_webViewPool;
 #endif
 };
 
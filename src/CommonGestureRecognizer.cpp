@@ -135,7 +135,9 @@ void CommonGestureRecognizer::capturePressOrRelease(QGraphicsSceneMouseEvent *ev
         // mouse press is more reliable than mouse release
         // we must send release with same coords as press
         copyMouseEventPositions(m_delayedPressEvent, m_delayedReleaseEvent);
-        m_delayedPressTimer.start(m_pressDelay, this);
+        // no need to wait for a second tap if it could not start a double tap,
+        // dispatch on the next event loop round instead
+        m_delayedPressTimer.start(m_consumer->isDoubleTapPossible(pos) ? m_pressDelay : 0, this);
     } else {
         m_delayedPressEvent = delayedEvent;
         m_delayedPressMoment.start();
@@ -38,6 +38,7 @@ public:
     virtual void mouseReleaseEventFromChild(QGraphicsSceneMouseEvent*) = 0;
     virtual void mouseDoubleClickEventFromChild(QGraphicsSceneMouseEvent*) = 0;
     virtual void adjustClickPosition(QPointF&) = 0;
+    virtual bool isDoubleTapPossible(const QPointF& scenePos) = 0;
 };
 
 class CommonGestureRecognizer : public QObject
@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "ContentFilter.h"
+
+#include <QFile>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTextStream>
+#include <QTimer>
+#include <QUrl>
+
+namespace {
+// shorter patterns would match too many urls by accident
+const int s_minPatternLength = 4;
+
+inline quint32 transitionKey(int node, char c)
+{
+    return (quint32(node) << 8) | quint8(c);
+}
+
+// "^" matches anything but a letter, a digit or one of "_-.%", and the end of the url
+inline bool isSeparator(char c)
+{
+    return !((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.' || c == '%');
+}
+
+bool matchesAt(const char* pattern, const char* patternEnd, const QByteArray& url, int pos)
+{
+    for (; pattern != patternEnd; ++pattern) {
+        switch (*pattern) {
+        case '*':
+            while (pattern + 1 != patternEnd && pattern[1] == '*')
+                ++pattern;
+            if (pattern + 1 == patternEnd)
+                return true;
+            for (int i = pos; i <= url.size(); ++i) {
+                if (matchesAt(pattern + 1, patternEnd, url, i))
+                    return true;
+            }
+            return false;
+        case '^':
+            if (pos == url.size())
+                continue;
+            if (!isSeparator(url.at(pos)))
+                return false;
+            ++pos;
+            continue;
+        case '|':
+            if (pattern + 1 == patternEnd)
+                return pos == url.size();
+            // fall through, a literal bar
+        default:
+            if (pos == url.size() || url.at(pos) != *pattern)
+                return false;
+            ++pos;
+        }
+    }
+    return true;
+}
+}
+
+class BlockedNetworkReply : public QNetworkReply {
+    Q_OBJECT
+public:
+    BlockedNetworkReply(const QNetworkRequest& request, QObject* parent);
+
+    void abort() {}
+    qint64 bytesAvailable() const { return 0; }
+
+protected:
+    qint64 readData(char*, qint64) { return -1; }
+
+private Q_SLOTS:
+    void finish();
+};
+
+BlockedNetworkReply::BlockedNetworkReply(const QNetworkRequest& request, QObject* parent)
+    : QNetworkReply(parent)
+{
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(QNetworkAccessManager::GetOperation);
+    setError(QNetworkReply::ContentAccessDenied, "Blocked by content filter");
+    open(QIODevice::ReadOnly);
+    // the page expects the reply signals after it has connected to them
+    QTimer::singleShot(0, this, SLOT(finish()));
+}
+
+void BlockedNetworkReply::finish()
+{
+    emit error(QNetworkReply::ContentAccessDenied);
+    emit finished();
+}
+
+/*! \class ContentFilter blocks requests to ad and tracker servers.
+
+  The filter list is a text file with one rule per line. Domain rules,
+  "||host^" or a hosts file entry, go to a hash set that is looked up
+  for the host and each of its parent domains. Other rules are url
+  patterns; the longest literal part of each goes into an Aho-Corasick
+  automaton, so a url is checked against all patterns in one pass, and
+  only the rules whose literal part occurs are matched in full, with
+  their anchors, wildcards and separators. Exceptions, rules with
+  options and element hiding rules are not supported; they are skipped
+  and counted.
+*/
+ContentFilter::ContentFilter(QObject* parent)
+    : QObject(parent)
+    , m_nodes(1)
+    , m_skippedRules(0)
+{
+}
+
+bool ContentFilter::load(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    while (!file.atEnd())
+        addRule(file.readLine().trimmed());
+    buildFailureLinks();
+    return !m_hosts.isEmpty() || !m_rules.isEmpty();
+}
+
+void ContentFilter::addRule(QByteArray rule)
+{
+    if (rule.isEmpty() || rule.startsWith('!') || rule.startsWith('[') || rule.startsWith('#'))
+        return;
+    rule = rule.toLower();
+
+    // hosts file entry, "address host # comment"
+    if (rule.contains(' ') || rule.contains('\t')) {
+        int comment = rule.indexOf('#');
+        if (comment != -1)
+            rule.truncate(comment);
+        QList<QByteArray> fields = rule.simplified().split(' ');
+        if (fields.size() < 2) {
+            m_skippedRules++;
+            return;
+        }
+        if (fields.at(1) != "localhost")
+            m_hosts.insert(fields.at(1));
+        return;
+    }
+
+    // applying a rule without its options or exceptions would block too much
+    if (rule.startsWith("@@") || rule.contains('$') || rule.contains("##") || rule.contains("#@#")) {
+        m_skippedRules++;
+        return;
+    }
+
+    if (rule.startsWith("||")) {
+        QByteArray host = rule.mid(2);
+        while (host.endsWith('^') || host.endsWith('/') || host.endsWith('|'))
+            host.chop(1);
+        if (!host.contains('/') && !host.contains('*') && !host.contains('^')) {
+            m_hosts.insert(host);
+            return;
+        }
+    }
+
+    UrlRule urlRule;
+    urlRule.anchor = UrlRule::NoAnchor;
+    if (rule.startsWith("||")) {
+        urlRule.anchor = UrlRule::DomainAnchor;
+        rule.remove(0, 2);
+    } else if (rule.startsWith('|')) {
+        urlRule.anchor = UrlRule::StartAnchor;
+        rule.remove(0, 1);
+    }
+    urlRule.pattern = rule;
+
+    // a url can only match when it contains the longest literal part
+    QByteArray longest;
+    foreach (const QByteArray& part, QByteArray(rule).replace('^', '*').replace('|', '*').split('*')) {
+        if (part.size() > longest.size())
+            longest = part;
+    }
+    if (longest.size() < s_minPatternLength) {
+        m_skippedRules++;
+        return;
+    }
+    m_rules.append(urlRule);
+    addLiteral(longest, m_rules.size() - 1);
+}
+
+void ContentFilter::addLiteral(const QByteArray& literal, int rule)
+{
+    int node = 0;
+    for (int i = 0; i < literal.size(); ++i) {
+        QHash<quint32, int>::const_iterator it = m_transitions.constFind(transitionKey(node, literal.at(i)));
+        if (it != m_transitions.constEnd()) {
+            node = *it;
+            continue;
+        }
+        m_nodes.append(Node());
+        m_transitions.insert(transitionKey(node, literal.at(i)), m_nodes.size() - 1);
+        node = m_nodes.size() - 1;
+    }
+    m_nodes[node].rules.append(rule);
+}
+
+void ContentFilter::buildFailureLinks()
+{
+    // breadth first so that the failure node of a node is done before it
+    QVector<QList<QPair<char, int> > > children(m_nodes.size());
+    QHash<quint32, int>::const_iterator it = m_transitions.constBegin();
+    for (; it != m_transitions.constEnd(); ++it)
+        children[it.key() >> 8].append(qMakePair(char(it.key() & 0xff), *it));
+
+    QList<int> queue;
+    queue.append(0);
+    while (!queue.isEmpty()) {
+        int node = queue.takeFirst();
+        for (int i = 0; i < children.at(node).size(); ++i) {
+            char c = children.at(node).at(i).first;
+            int child = children.at(node).at(i).second;
+            int failure = 0;
+            if (node) {
+                failure = m_nodes.at(node).failure;
+                while (failure && transition(failure, c) == -1)
+                    failure = m_nodes.at(failure).failure;
+                failure = qMax(transition(failure, c), 0);
+            }
+            m_nodes[child].failure = failure;
+            m_nodes[child].output = m_nodes.at(failure).rules.isEmpty() ? m_nodes.at(failure).output : failure;
+            queue.append(child);
+        }
+    }
+}
+
+int ContentFilter::transition(int node, char c) const
+{
+    return m_transitions.value(transitionKey(node, c), -1);
+}
+
+bool ContentFilter::matchesHost(const QByteArray& host) const
+{
+    if (m_hosts.isEmpty())
+        return false;
+    int start = 0;
+    while (start != -1) {
+        if (m_hosts.contains(QByteArray::fromRawData(host.constData() + start, host.size() - start)))
+            return true;
+        start = host.indexOf('.', start);
+        if (start != -1)
+            start++;
+    }
+    return false;
+}
+
+bool ContentFilter::matchesRule(const UrlRule& rule, const QByteArray& url) const
+{
+    const char* pattern = rule.pattern.constData();
+    const char* patternEnd = pattern + rule.pattern.size();
+    switch (rule.anchor) {
+    case UrlRule::StartAnchor:
+        return matchesAt(pattern, patternEnd, url, 0);
+    case UrlRule::DomainAnchor: {
+        // at the start of the host or of one of its labels
+        int hostStart = url.indexOf("://");
+        if (hostStart == -1)
+            return false;
+        hostStart += 3;
+        for (int i = hostStart; i < url.size() && url.at(i) != '/' && url.at(i) != ':' && url.at(i) != '?'; ++i) {
+            if ((i == hostStart || url.at(i - 1) == '.') && matchesAt(pattern, patternEnd, url, i))
+                return true;
+        }
+        return false;
+    }
+    default:
+        for (int i = 0; i <= url.size(); ++i) {
+            if (matchesAt(pattern, patternEnd, url, i))
+                return true;
+        }
+        return false;
+    }
+}
+
+bool ContentFilter::matchesPattern(const QByteArray& url) const
+{
+    if (m_rules.isEmpty())
+        return false;
+    int node = 0;
+    for (int i = 0; i < url.size(); ++i) {
+        char c = url.at(i);
+        int next = transition(node, c);
+        while (next == -1 && node) {
+            node = m_nodes.at(node).failure;
+            next = transition(node, c);
+        }
+        node = qMax(next, 0);
+        for (int found = m_nodes.at(node).rules.isEmpty() ? m_nodes.at(node).output : node; found != -1; found = m_nodes.at(found).output) {
+            foreach (int rule, m_nodes.at(found).rules) {
+                if (matchesRule(m_rules.at(rule), url))
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool ContentFilter::blocks(const QUrl& url) const
+{
+    if (url.scheme() != "http" && url.scheme() != "https")
+        return false;
+    return matchesHost(url.host().toLower().toUtf8()) || matchesPattern(url.toEncoded().toLower());
+}
+
+QNetworkReply* ContentFilter::createBlockedReply(const QNetworkRequest& request, QObject* parent) const
+{
+    return new BlockedNetworkReply(request, parent);
+}
+
+void ContentFilter::writeReport(QTextStream& stream) const
+{
+    stream << "hosts in filter: " << m_hosts.size() << endl;
+    stream << "url patterns in filter: " << m_rules.size() << " (" << m_nodes.size() << " states)" << endl;
+    stream << "unsupported rules: " << m_skippedRules << endl;
+}
+
+#include "ContentFilter.moc"
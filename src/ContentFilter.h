@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ContentFilter_h
+#define ContentFilter_h
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+#include "yberconfig.h"
+
+class QNetworkReply;
+class QNetworkRequest;
+class QTextStream;
+class QUrl;
+
+class ContentFilter : public QObject
+{
+    Q_OBJECT
+public:
+    ContentFilter(QObject* parent = 0);
+
+    bool load(const QString& filePath);
+    bool blocks(const QUrl&) const;
+
+    QNetworkReply* createBlockedReply(const QNetworkRequest&, QObject* parent) const;
+
+    void writeReport(QTextStream&) const;
+
+private:
+    Q_DISABLE_COPY(ContentFilter)
+
+    struct UrlRule {
+        enum Anchor { NoAnchor, StartAnchor, DomainAnchor };
+        Anchor anchor;
+        // lower case, without the start anchor
+        QByteArray pattern;
+    };
+
+    void addRule(QByteArray rule);
+    void addLiteral(const QByteArray& literal, int rule);
+    void buildFailureLinks();
+    int transition(int node, char c) const;
+    bool matchesHost(const QByteArray& host) const;
+    bool matchesPattern(const QByteArray& url) const;
+    bool matchesRule(const UrlRule&, const QByteArray& url) const;
+
+    struct Node {
+        Node() : failure(0), output(-1) {}
+        int failure;
+        // the nearest node on the failure chain that ends literals, -1 if none
+        int output;
+        // the rules whose literal ends here
+        QList<int> rules;
+    };
+
+    QSet<QByteArray> m_hosts;
+    QVector<UrlRule> m_rules;
+    // Aho-Corasick automaton over the literal parts of the rules, node 0 is the root
+    QVector<Node> m_nodes;
+    QHash<quint32, int> m_transitions;
+    int m_skippedRules;
+};
+
+#endif
@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "DiskCache.h"
+#include "Settings.h"
+
+#include <QDataStream>
+#include <QDirIterator>
+#include <QFile>
+#include <QMap>
+#include <QSet>
+#include <QTextStream>
+#include <QTimerEvent>
+
+namespace {
+// eviction makes room for some more entries instead of just the one being added
+const qreal s_expireTargetRatio = 0.9;
+// larger responses would push out many small ones
+const int s_maxEntryShareOfBudget = 8;
+// last use is written out in batches, not on every hit
+const int s_lastUseSaveDelayMS = 10000;
+const quint32 s_lastUseVersion = 2;
+// a lookup the network stack did not follow up within this time was dropped
+const int s_lookupTimeoutMS = 30000;
+// lookups are checked for timeouts when there are more of them than this
+const int s_maxPendingLookups = 64;
+}
+
+/*! \class DiskCache HTTP cache kept in the private directory across runs.
+
+  Entries are stored by QNetworkDiskCache and revalidated by the network
+  stack with the stored validators once they are stale. Unlike the base
+  class, which drops the oldest written entries first, the cache evicts
+  the least recently used entries when it exceeds its budget. The time
+  each entry was last read is kept in a file next to the cache, so the
+  order survives restarts. The same file keeps the url of each cache
+  file, so that eviction reads the meta data of a file only once rather
+  than on every expire().
+*/
+DiskCache::DiskCache(QObject* parent)
+    : QNetworkDiskCache(parent)
+    , m_lookups(0)
+    , m_hits(0)
+    , m_revalidations(0)
+    , m_inserts(0)
+    , m_skippedInserts(0)
+    , m_evictions(0)
+    , m_evictedBytes(0)
+    , m_updatingMetaData(false)
+{
+    setCacheDirectory(Settings::instance()->diskCacheDirectory());
+    setMaximumCacheSize(Settings::instance()->diskCacheSize());
+    m_clock.start();
+    loadLastUse();
+}
+
+/*!
+  The HTTP backend looks up the meta data of every cacheable request
+  first, and reads the data only when it serves the entry. When the
+  server confirms a stale entry with a 304, it looks the entry up once
+  more before reading it, which tells revalidations from fresh hits. A
+  lookup that is not followed up, as with a cancelled request, times out
+  and the next one counts as a new lookup.
+*/
+QNetworkCacheMetaData DiskCache::metaData(const QUrl& url)
+{
+    QNetworkCacheMetaData metaData = QNetworkDiskCache::metaData(url);
+    if (!metaData.isValid()) {
+        m_lookups++;
+        return metaData;
+    }
+    int now = m_clock.elapsed();
+    QHash<QUrl, int>::iterator lookedUp = m_lookedUp.find(url);
+    if (lookedUp != m_lookedUp.end() && now - *lookedUp < s_lookupTimeoutMS)
+        m_revalidating.insert(url, now);
+    else {
+        m_lookups++;
+        m_lookedUp.insert(url, now);
+        m_revalidating.remove(url);
+        if (m_lookedUp.size() > s_maxPendingLookups)
+            pruneLookups();
+    }
+    return metaData;
+}
+
+void DiskCache::pruneLookups()
+{
+    int now = m_clock.elapsed();
+    QHash<QUrl, int>::iterator it = m_lookedUp.begin();
+    while (it != m_lookedUp.end()) {
+        if (now - *it < s_lookupTimeoutMS)
+            ++it;
+        else {
+            m_revalidating.remove(it.key());
+            it = m_lookedUp.erase(it);
+        }
+    }
+}
+
+QIODevice* DiskCache::data(const QUrl& url)
+{
+    QIODevice* device = QNetworkDiskCache::data(url);
+    // updateMetaData() of the base class copies the data through here
+    if (m_updatingMetaData)
+        return device;
+    m_lookedUp.remove(url);
+    bool revalidated = m_revalidating.remove(url);
+    if (device) {
+        m_hits++;
+        if (revalidated)
+            m_revalidations++;
+        markUsed(url);
+    }
+    return device;
+}
+
+void DiskCache::markUsed(const QUrl& url)
+{
+    m_lastUsed.insert(url, QDateTime::currentDateTime());
+    if (!m_lastUseSaveTimer.isActive())
+        m_lastUseSaveTimer.start(s_lastUseSaveDelayMS, this);
+}
+
+void DiskCache::timerEvent(QTimerEvent* ev)
+{
+    if (ev->timerId() == m_lastUseSaveTimer.timerId()) {
+        m_lastUseSaveTimer.stop();
+        saveLastUse();
+        return;
+    }
+    QNetworkDiskCache::timerEvent(ev);
+}
+
+void DiskCache::loadLastUse()
+{
+    QFile file(Settings::instance()->diskCacheUseFilePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    QDataStream stream(&file);
+    quint32 version;
+    stream >> version;
+    if (stream.status() != QDataStream::Ok || version != s_lastUseVersion)
+        return;
+    stream >> m_lastUsed >> m_fileUrls;
+    if (stream.status() != QDataStream::Ok) {
+        m_lastUsed.clear();
+        m_fileUrls.clear();
+    }
+}
+
+void DiskCache::saveLastUse()
+{
+    QString path = Settings::instance()->diskCacheUseFilePath();
+    QFile file(path + ".tmp");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return;
+    QDataStream stream(&file);
+    stream << s_lastUseVersion << m_lastUsed << m_fileUrls;
+    file.close();
+    if (stream.status() != QDataStream::Ok || file.error() != QFile::NoError) {
+        file.remove();
+        return;
+    }
+    QFile::remove(path);
+    file.rename(path);
+}
+
+QIODevice* DiskCache::prepare(const QNetworkCacheMetaData& metaData)
+{
+    if (!m_updatingMetaData) {
+        // the server sent a new copy
+        m_lookedUp.remove(metaData.url());
+        m_revalidating.remove(metaData.url());
+    }
+    foreach (const QNetworkCacheMetaData::RawHeader& header, metaData.rawHeaders()) {
+        if (header.first.toLower() == "content-length"
+            && header.second.toLongLong() > maximumCacheSize() / s_maxEntryShareOfBudget) {
+            m_skippedInserts++;
+            return 0;
+        }
+    }
+    return QNetworkDiskCache::prepare(metaData);
+}
+
+void DiskCache::insert(QIODevice* device)
+{
+    if (!m_updatingMetaData)
+        m_inserts++;
+    QNetworkDiskCache::insert(device);
+}
+
+void DiskCache::updateMetaData(const QNetworkCacheMetaData& metaData)
+{
+    // only called when a 304 changed the stored headers, data() counts the revalidation
+    m_updatingMetaData = true;
+    QNetworkDiskCache::updateMetaData(metaData);
+    m_updatingMetaData = false;
+}
+
+qint64 DiskCache::expire()
+{
+    qint64 budget = maximumCacheSize();
+    QMap<QDateTime, QString> entries;
+    QHash<QString, QUrl> fileUrls;
+    bool readFiles = false;
+    qint64 totalSize = 0;
+    QDirIterator it(cacheDirectory(), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QString path = it.next();
+        // files still being written
+        if (path.contains("/prepared/"))
+            continue;
+        QFileInfo info = it.fileInfo();
+        totalSize += info.size();
+        QDateTime lastUsed = info.lastModified();
+        QHash<QString, QUrl>::const_iterator known = m_fileUrls.constFind(path);
+        if (known != m_fileUrls.constEnd() || !m_lastUsed.isEmpty()) {
+            // only files written since the last expire() are read
+            QUrl url;
+            if (known != m_fileUrls.constEnd())
+                url = *known;
+            else {
+                url = fileMetaData(path).url();
+                readFiles = true;
+            }
+            fileUrls.insert(path, url);
+            QHash<QUrl, QDateTime>::const_iterator used = m_lastUsed.constFind(url);
+            if (used != m_lastUsed.constEnd())
+                lastUsed = *used;
+        }
+        entries.insertMulti(lastUsed, path);
+    }
+
+    // forget the files and the last use of entries that are gone
+    m_fileUrls = fileUrls;
+    if (!m_lastUsed.isEmpty()) {
+        QSet<QUrl> cached = fileUrls.values().toSet();
+        QHash<QUrl, QDateTime>::iterator used = m_lastUsed.begin();
+        while (used != m_lastUsed.end()) {
+            if (cached.contains(used.key()))
+                ++used;
+            else
+                used = m_lastUsed.erase(used);
+        }
+    }
+    if (readFiles && !m_lastUseSaveTimer.isActive())
+        m_lastUseSaveTimer.start(s_lastUseSaveDelayMS, this);
+    if (totalSize < budget)
+        return totalSize;
+
+    qint64 target = budget * s_expireTargetRatio;
+    QMap<QDateTime, QString>::const_iterator entry = entries.constBegin();
+    for (; entry != entries.constEnd() && totalSize > target; ++entry) {
+        QFile file(*entry);
+        qint64 size = file.size();
+        if (!file.remove())
+            continue;
+        totalSize -= size;
+        m_evictions++;
+        m_evictedBytes += size;
+        m_lastUsed.remove(m_fileUrls.take(*entry));
+    }
+    if (!m_lastUseSaveTimer.isActive())
+        m_lastUseSaveTimer.start(s_lastUseSaveDelayMS, this);
+    return totalSize;
+}
+
+void DiskCache::writeReport(QTextStream& stream) const
+{
+    stream << "[disk cache]" << endl;
+    stream << "size: " << cacheSize() / 1024 << "kB of " << maximumCacheSize() / 1024 << "kB" << endl;
+    stream << "lookups: " << m_lookups << endl;
+    stream << "hits: " << m_hits;
+    if (m_lookups)
+        stream << " (" << QString::number(100. * m_hits / m_lookups, 'f', 1) << "%)";
+    stream << endl;
+    stream << "revalidated: " << m_revalidations << endl;
+    stream << "stored: " << m_inserts << endl;
+    stream << "too large to store: " << m_skippedInserts << endl;
+    stream << "evicted: " << m_evictions << " (" << m_evictedBytes / 1024 << "kB)" << endl;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef DiskCache_h
+#define DiskCache_h
+
+#include <QBasicTimer>
+#include <QDateTime>
+#include <QHash>
+#include <QNetworkDiskCache>
+#include <QTime>
+#include <QUrl>
+#include "yberconfig.h"
+
+class QTextStream;
+
+class DiskCache : public QNetworkDiskCache
+{
+    Q_OBJECT
+public:
+    DiskCache(QObject* parent = 0);
+
+    QNetworkCacheMetaData metaData(const QUrl&);
+    QIODevice* data(const QUrl&);
+    QIODevice* prepare(const QNetworkCacheMetaData&);
+    void insert(QIODevice*);
+    void updateMetaData(const QNetworkCacheMetaData&);
+
+    void writeReport(QTextStream&) const;
+
+protected:
+    qint64 expire();
+    void timerEvent(QTimerEvent*);
+
+private:
+    Q_DISABLE_COPY(DiskCache)
+
+    void markUsed(const QUrl&);
+    void pruneLookups();
+    void loadLastUse();
+    void saveLastUse();
+
+    // last use of the entries read from the cache, kept across runs,
+    // other entries count as used when they were written
+    QHash<QUrl, QDateTime> m_lastUsed;
+    // the url of each cache file, read from the file once and kept
+    // across runs with the last use
+    QHash<QString, QUrl> m_fileUrls;
+    QBasicTimer m_lastUseSaveTimer;
+    // entries found and not read or replaced yet, and those of them
+    // the network stack looked up again after a 304, with the time of
+    // the lookup on m_clock
+    QHash<QUrl, int> m_lookedUp;
+    QHash<QUrl, int> m_revalidating;
+    QTime m_clock;
+    bool m_updatingMetaData;
+    int m_lookups;
+    int m_hits;
+    int m_revalidations;
+    int m_inserts;
+    int m_skippedInserts;
+    int m_evictions;
+    qint64 m_evictedBytes;
+};
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "FrameClock.h"
+
+#include <QTimerEvent>
+
+namespace {
+const int s_framesPerSecond = 60;
+}
+
+/*! \class FrameClock shared source of animation frames.
+
+  Everything that moves on screen advances on the frame() signal, so
+  that the scroller, pan handling and layout work for one displayed
+  frame happen together. The clock only ticks while somebody is
+  subscribed. frameTime() is sampled once per tick and is the same for
+  all receivers of a frame.
+*/
+FrameClock::FrameClock()
+    : m_frameTime(0)
+    , m_frameNumber(0)
+{
+    m_clock.start();
+}
+
+FrameClock* FrameClock::instance()
+{
+    static FrameClock* self = 0;
+    if (!self)
+        self = new FrameClock;
+    return self;
+}
+
+int FrameClock::frameInterval() const
+{
+    return 1000 / s_framesPerSecond;
+}
+
+void FrameClock::subscribe(QObject* receiver, const char* member)
+{
+    connect(this, SIGNAL(frame()), receiver, member, Qt::UniqueConnection);
+    if (!m_frameTimer.isActive()) {
+        m_frameTime = m_clock.elapsed();
+        m_frameTimer.start(frameInterval(), this);
+    }
+}
+
+void FrameClock::unsubscribe(QObject* receiver, const char* member)
+{
+    disconnect(this, SIGNAL(frame()), receiver, member);
+    if (!receivers(SIGNAL(frame())))
+        m_frameTimer.stop();
+}
+
+void FrameClock::timerEvent(QTimerEvent* ev)
+{
+    if (ev->timerId() != m_frameTimer.timerId()) {
+        QObject::timerEvent(ev);
+        return;
+    }
+
+    // receivers that were deleted without unsubscribing
+    if (!receivers(SIGNAL(frame()))) {
+        m_frameTimer.stop();
+        return;
+    }
+    m_frameTime = m_clock.elapsed();
+    m_frameNumber++;
+    emit frame();
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef FrameClock_h
+#define FrameClock_h
+
+#include <QBasicTimer>
+#include <QObject>
+#include <QTime>
+#include "yberconfig.h"
+
+class FrameClock : public QObject
+{
+    Q_OBJECT
+public:
+    static FrameClock* instance();
+
+    void subscribe(QObject* receiver, const char* member);
+    void unsubscribe(QObject* receiver, const char* member);
+
+    int frameTime() const { return m_frameTime; }
+    int frameInterval() const;
+    unsigned frameNumber() const { return m_frameNumber; }
+    int elapsed() const { return m_clock.elapsed(); }
+    bool isTicking() const { return m_frameTimer.isActive(); }
+
+Q_SIGNALS:
+    void frame();
+
+protected:
+    void timerEvent(QTimerEvent*);
+
+private:
+    FrameClock();
+    Q_DISABLE_COPY(FrameClock)
+
+    QBasicTimer m_frameTimer;
+    QTime m_clock;
+    int m_frameTime;
+    unsigned m_frameNumber;
+};
+
+#endif
@@ -24,7 +24,7 @@
 #include "TileItem.h"
 #include "HistoryStore.h"
 #include "BookmarkStore.h"
-#include "WebView.h"
+#include "BrowserTab.h"
 
 #include <QGraphicsSceneMouseEvent>
 #include <QPropertyAnimation>
@@ -34,7 +34,8 @@
 #include <MScene>
 #endif
 
-const int s_maxWindows = 6;
+// the tab grid is filled up to one screen with empty markers
+const int s_tabTilesPerScreen = 6;
 const int s_containerYBottomMargin = 10;
 const int s_maxHistoryTileNum = 19;
 const int s_horizontalFlickLockThreshold = 20;
@@ -136,7 +137,7 @@ void HomeView::tileItemActivated(TileItem* item)
     TileSelectionViewBase::tileItemActivated(item);
     // FIXME: type should really be representing the functionality
     if (m_activeWidget == WindowSelect && item->tileType() == TileItem::ThumbnailTile)
-        emit windowSelected((WebView*)item->context());
+        emit windowSelected((BrowserTab*)item->context());
     else if (item->tileType() == TileItem::NewWindowTile)
         emit windowCreated();
     else if (item->tileType() == TileItem::ThumbnailTile || item->tileType() == TileItem::ListTile)
@@ -152,7 +153,7 @@ void HomeView::tileItemClosed(TileItem* item)
     widgetByType(m_activeWidget)->removeTile(*item);
 
     if (m_activeWidget == WindowSelect && item->tileType() == TileItem::ThumbnailTile)
-        emit windowClosed((WebView*)item->context());
+        emit windowClosed((BrowserTab*)item->context());
 }
 
 void HomeView::tileItemEditingMode(TileItem* item)
@@ -272,11 +273,15 @@ void HomeView::createTabSelectContent()
     // create tile list out of window list
     int i = 0;
     for (; i < m_windowList->size(); ++i) {
-        WebView* view = m_windowList->at(i);
+        BrowserTab* view = m_windowList->at(i);
         bool pageAvailable = !view->url().isEmpty();
         QImage* thumbnail = 0;
     
-        if (pageAvailable) {
+        // a hibernated tab keeps its own copy, the history may have dropped it
+        QImage tabThumbnail = view->thumbnail();
+        if (!tabThumbnail.isNull())
+            thumbnail = new QImage(tabThumbnail);
+        else if (pageAvailable) {
             // get the thumbnail from history store, it'd better be there
             const UrlList& l = HistoryStore::instance()->list();
             for (int i = 0; i < l.size(); ++i) {
@@ -300,7 +305,7 @@ void HomeView::createTabSelectContent()
     connectItem(*createTabItem);
     i++;
     
-    for (; i < s_maxWindows; i++) {
+    for (; i < s_tabTilesPerScreen; i++) {
         NewWindowMarkerTileItem* emptyMarkerItem = new NewWindowMarkerTileItem(m_tabWidget, UrlItem(QUrl(), "", 0));
         m_tabWidget->addTile(*emptyMarkerItem);
         connectItem(*emptyMarkerItem);
@@ -30,7 +30,7 @@ class TabWidget;
 class PannableTileContainer;
 class TileItem;
 class QGraphicsSceneMouseEvent;
-class WebView;
+class BrowserTab;
 class TileBaseWidget;
 
 class HomeView : public TileSelectionViewBase {
@@ -45,7 +45,7 @@ public:
     HomeView(HomeWidgetType initialWidget, QGraphicsPixmapItem* bckg, QGraphicsItem* parent = 0, Qt::WindowFlags wFlags = 0);
     ~HomeView();
     
-    void setWindowList(QList<WebView*>& windowList) { m_windowList = &windowList; }
+    void setWindowList(QList<BrowserTab*>& windowList) { m_windowList = &windowList; }
     HomeWidgetType activeWidget() const { return m_activeWidget; }
     void setActiveWidget(HomeWidgetType widget);
     // FIXME temp hack until event handling is fixed
@@ -53,8 +53,8 @@ public:
 
 Q_SIGNALS:
     void pageSelected(const QUrl&);
-    void windowSelected(WebView* webView);
-    void windowClosed(WebView* webView);
+    void windowSelected(BrowserTab* window);
+    void windowClosed(BrowserTab* window);
     void windowCreated();
 
 private Q_SLOTS:
@@ -84,7 +84,7 @@ private:
     PannableTileContainer* m_pannableHistoryContainer;
     PannableTileContainer* m_pannableBookmarkContainer;
     PannableTileContainer* m_pannableWindowSelectContainer;
-    QList<WebView*>* m_windowList;
+    QList<BrowserTab*>* m_windowList;
 
     // FIXME these should go to a gesture recognizer
     QTime m_flickTime;
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "InputResampler.h"
+
+#if defined(Q_WS_X11)
+#include <QX11Info>
+#endif
+
+namespace {
+const int s_maxSamples = 4;
+// how far behind the frame time positions are interpolated
+const int s_resampleLatencyMS = 5;
+// how far ahead of the frame time positions are predicted
+const int s_predictionMS = 8;
+// never extrapolate further than this past the latest sample
+const int s_maxPredictionMS = 16;
+// samples further apart than this, or older, describe no current motion
+const int s_maxSampleGapMS = 40;
+const int s_maxSampleAgeMS = 20;
+// an event clock further off than this has been reset or wrapped around
+const int s_maxEventClockSkewMS = 1000;
+
+QPointF interpolate(const QPointF& from, int fromTime, const QPointF& to, int toTime, int time)
+{
+    if (toTime == fromTime)
+        return to;
+    return from + (to - from) * qreal(time - fromTime) / qreal(toTime - fromTime);
+}
+}
+
+/*! \class InputResampler turns unevenly timed pointer samples into one
+  position per frame.
+
+  Pointer events arrive at their own rate, which beats against the frame
+  rate: some frames see two moves, some none. Applying the latest raw
+  position makes the content jitter. The resampler interpolates the
+  position at a fixed small latency behind the frame time instead, or,
+  with prediction, extrapolates a few milliseconds ahead of it so that
+  the content keeps up with the finger.
+
+  Times are in milliseconds on the FrameClock. Samples are placed at the
+  time their event was generated, not at the time it got delivered, as
+  delivery is delayed by whatever the event loop was busy with.
+*/
+InputResampler::InputResampler()
+    : m_hasEventClockOffset(false)
+    , m_eventClockOffset(0)
+{
+}
+
+/*!
+  Returns the time the event being handled was generated, on the
+  FrameClock. \a deliveryTime is the FrameClock time now.
+
+  On X11 the server timestamp of an event that came from the window
+  system is mapped onto the FrameClock with the smallest delivery delay
+  seen so far. Synthesized events, like those of the drag test, carry
+  no server timestamp and get their delivery time, as do all events
+  elsewhere, where Qt 4 has no event timestamps.
+*/
+int InputResampler::eventTime(int deliveryTime, bool fromWindowSystem)
+{
+#if defined(Q_WS_X11)
+    if (!fromWindowSystem)
+        return deliveryTime;
+    int serverTime = QX11Info::appTime();
+    int offset = deliveryTime - serverTime;
+    if (!m_hasEventClockOffset || offset < m_eventClockOffset || offset - m_eventClockOffset > s_maxEventClockSkewMS) {
+        m_eventClockOffset = offset;
+        m_hasEventClockOffset = true;
+    }
+    return serverTime + m_eventClockOffset;
+#else
+    Q_UNUSED(fromWindowSystem);
+    return deliveryTime;
+#endif
+}
+
+void InputResampler::reset()
+{
+    m_samples.clear();
+}
+
+void InputResampler::addSample(const QPointF& pos, int time)
+{
+    if (!m_samples.isEmpty() && m_samples.last().time >= time)
+        m_samples.removeLast();
+    m_samples.append(Sample(pos, time));
+    if (m_samples.size() > s_maxSamples)
+        m_samples.removeFirst();
+}
+
+QPointF InputResampler::latestPosition() const
+{
+    return m_samples.isEmpty() ? QPointF() : m_samples.last().pos;
+}
+
+QPointF InputResampler::positionAt(int frameTime, bool predict) const
+{
+    if (m_samples.size() < 2)
+        return latestPosition();
+
+    const Sample& last = m_samples.last();
+    int sampleTime = predict ? frameTime + s_predictionMS : frameTime - s_resampleLatencyMS;
+
+    if (sampleTime <= last.time) {
+        for (int i = m_samples.size() - 1; i > 0; --i) {
+            const Sample& from = m_samples.at(i - 1);
+            if (sampleTime >= from.time)
+                return interpolate(from.pos, from.time, m_samples.at(i).pos, m_samples.at(i).time, sampleTime);
+        }
+        return m_samples.first().pos;
+    }
+
+    if (!predict)
+        return last.pos;
+
+    // the finger has stopped or the motion is too sparse to extrapolate
+    const Sample& previous = m_samples.at(m_samples.size() - 2);
+    if (frameTime - last.time > s_maxSampleAgeMS || last.time - previous.time > s_maxSampleGapMS)
+        return last.pos;
+
+    return interpolate(previous.pos, previous.time, last.pos, last.time, last.time + qMin(sampleTime - last.time, s_maxPredictionMS));
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef InputResampler_h
+#define InputResampler_h
+
+#include <QList>
+#include <QPointF>
+#include "yberconfig.h"
+
+class InputResampler
+{
+public:
+    InputResampler();
+
+    void reset();
+    void addSample(const QPointF& pos, int time);
+    int eventTime(int deliveryTime, bool fromWindowSystem);
+
+    bool isEmpty() const { return m_samples.isEmpty(); }
+    QPointF latestPosition() const;
+    QPointF positionAt(int frameTime, bool predict) const;
+
+private:
+    struct Sample {
+        Sample(const QPointF& p, int t) : pos(p), time(t) { }
+        QPointF pos;
+        int time;
+    };
+
+    QList<Sample> m_samples;
+    bool m_hasEventClockOffset;
+    int m_eventClockOffset;
+};
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "NetworkAccessManager.h"
+#include "ContentFilter.h"
+#include "DiskCache.h"
+#include "NetworkTimingLog.h"
+
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTextStream>
+#if !USE_WEBKIT2
+#include <qwebframe.h>
+#include <qwebpage.h>
+#endif
+
+/*! \class NetworkAccessManager the network stack shared by all pages.
+
+  Every page, the suggestion view and the tests load through the one
+  manager, so they share its connection pool, authentication cache and
+  cookie jar. Traffic is still accounted for each page, and
+  requestStarted() lets per page features hook into the requests of
+  their page. The manager tracks the lifetime of every reply it starts,
+  requestFinished() or requestDropped(), for a reply deleted without
+  finishing, tells when it is over.
+*/
+NetworkAccessManager::NetworkAccessManager(QObject* parent)
+    : QNetworkAccessManager(parent)
+    , m_cachedReplies(0)
+    , m_contentFilter(0)
+    , m_timingLog(new NetworkTimingLog(this))
+{
+    connect(this, SIGNAL(requestStarted(QWebPage*, QNetworkReply*)), m_timingLog, SLOT(requestStarted(QWebPage*, QNetworkReply*)));
+    connect(this, SIGNAL(requestFinished(QNetworkReply*)), m_timingLog, SLOT(requestFinished(QNetworkReply*)));
+    connect(this, SIGNAL(requestDropped(QObject*)), m_timingLog, SLOT(requestDropped(QObject*)));
+}
+
+QWebPage* NetworkAccessManager::originatingPage(const QNetworkRequest& request) const
+{
+#if !USE_WEBKIT2 && QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
+    // QtWebKit tags its requests with the frame that made them
+    if (QWebFrame* frame = qobject_cast<QWebFrame*>(request.originatingObject()))
+        return frame->page();
+#else
+    Q_UNUSED(request)
+#endif
+    return 0;
+}
+
+QNetworkReply* NetworkAccessManager::createRequest(Operation op, const QNetworkRequest& request, QIODevice* outgoingData)
+{
+    QWebPage* page = originatingPage(request);
+    Traffic* pageTraffic = 0;
+    if (page) {
+        if (!m_pageTraffic.contains(page))
+            connect(page, SIGNAL(destroyed(QObject*)), this, SLOT(pageDestroyed(QObject*)));
+        pageTraffic = &m_pageTraffic[page];
+    }
+
+    if (m_contentFilter && m_contentFilter->blocks(request.url())) {
+        m_totalTraffic.blockedRequests++;
+        if (pageTraffic)
+            pageTraffic->blockedRequests++;
+        return m_contentFilter->createBlockedReply(request, this);
+    }
+
+    QNetworkReply* reply = QNetworkAccessManager::createRequest(op, request, outgoingData);
+    m_totalTraffic.requests++;
+    if (pageTraffic)
+        pageTraffic->requests++;
+
+    PendingReply& pending = m_pendingReplies[reply];
+    pending.page = page;
+    connect(reply, SIGNAL(downloadProgress(qint64, qint64)), this, SLOT(replyDownloadProgress(qint64, qint64)));
+    connect(reply, SIGNAL(finished()), this, SLOT(replyFinished()));
+    connect(reply, SIGNAL(destroyed(QObject*)), this, SLOT(replyDestroyed(QObject*)));
+
+    emit requestStarted(page, reply);
+    return reply;
+}
+
+void NetworkAccessManager::replyDownloadProgress(qint64 bytesReceived, qint64)
+{
+    QHash<QObject*, PendingReply>::iterator it = m_pendingReplies.find(sender());
+    if (it != m_pendingReplies.end())
+        it->bytesReceived = bytesReceived;
+}
+
+void NetworkAccessManager::replyFinished()
+{
+    QNetworkReply* reply = static_cast<QNetworkReply*>(sender());
+    if (!m_pendingReplies.contains(reply))
+        return;
+
+    if (reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool())
+        m_cachedReplies++;
+    accountReply(reply);
+    disconnect(reply, 0, this, 0);
+    emit requestFinished(reply);
+}
+
+void NetworkAccessManager::replyDestroyed(QObject* reply)
+{
+    if (!m_pendingReplies.contains(reply))
+        return;
+    // deleted without finishing, what it received still counts
+    accountReply(reply);
+    emit requestDropped(reply);
+}
+
+void NetworkAccessManager::accountReply(QObject* reply)
+{
+    QHash<QObject*, PendingReply>::iterator it = m_pendingReplies.find(reply);
+    if (it == m_pendingReplies.end())
+        return;
+
+    m_totalTraffic.bytesReceived += it->bytesReceived;
+    // the page may have gone while the reply was running
+    QHash<QObject*, Traffic>::iterator page = m_pageTraffic.find(it->page);
+    if (page != m_pageTraffic.end())
+        page->bytesReceived += it->bytesReceived;
+    m_pendingReplies.erase(it);
+}
+
+void NetworkAccessManager::pageDestroyed(QObject* page)
+{
+    m_pageTraffic.remove(page);
+}
+
+NetworkAccessManager::Traffic NetworkAccessManager::pageTraffic(QWebPage* page) const
+{
+    return m_pageTraffic.value(page);
+}
+
+/*!
+  Blocked requests never receive anything, so what they would have
+  cost is estimated from the mean size of the replies that were loaded.
+*/
+qint64 NetworkAccessManager::estimatedBlockedBytes(int blockedRequests) const
+{
+    int finished = m_totalTraffic.requests - m_pendingReplies.size();
+    if (finished <= 0)
+        return 0;
+    return blockedRequests * (m_totalTraffic.bytesReceived / finished);
+}
+
+void NetworkAccessManager::writeReport(QTextStream& stream) const
+{
+    stream << "[network]" << endl;
+    stream << "requests: " << m_totalTraffic.requests << endl;
+    stream << "from cache: " << m_cachedReplies << endl;
+    stream << "received: " << m_totalTraffic.bytesReceived / 1024 << "kB" << endl;
+    stream << "in flight: " << m_pendingReplies.size() << endl;
+    if (m_contentFilter) {
+        stream << "blocked: " << m_totalTraffic.blockedRequests << " (about "
+               << estimatedBlockedBytes(m_totalTraffic.blockedRequests) / 1024 << "kB)" << endl;
+        m_contentFilter->writeReport(stream);
+    }
+#if !USE_WEBKIT2
+    QHash<QObject*, Traffic>::const_iterator it = m_pageTraffic.constBegin();
+    for (; it != m_pageTraffic.constEnd(); ++it) {
+        QWebPage* page = static_cast<QWebPage*>(it.key());
+        stream << page->mainFrame()->url().host() << ": " << it->requests << " requests, "
+               << it->bytesReceived / 1024 << "kB";
+        if (it->blockedRequests)
+            stream << ", " << it->blockedRequests << " blocked (about " << estimatedBlockedBytes(it->blockedRequests) / 1024 << "kB)";
+        stream << endl;
+    }
+#endif
+    if (DiskCache* diskCache = qobject_cast<DiskCache*>(cache())) {
+        stream << endl;
+        diskCache->writeReport(stream);
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef NetworkAccessManager_h
+#define NetworkAccessManager_h
+
+#include <QHash>
+#include <QNetworkAccessManager>
+#include "yberconfig.h"
+
+class ContentFilter;
+class NetworkTimingLog;
+class QTextStream;
+class QWebPage;
+
+class NetworkAccessManager : public QNetworkAccessManager
+{
+    Q_OBJECT
+public:
+    struct Traffic {
+        Traffic() : requests(0), bytesReceived(0), blockedRequests(0) {}
+        int requests;
+        qint64 bytesReceived;
+        int blockedRequests;
+    };
+
+    NetworkAccessManager(QObject* parent = 0);
+
+    void setContentFilter(ContentFilter* filter) { m_contentFilter = filter; }
+    NetworkTimingLog* timingLog() const { return m_timingLog; }
+
+    Traffic pageTraffic(QWebPage*) const;
+    void writeReport(QTextStream&) const;
+
+Q_SIGNALS:
+    // page is 0 for requests that do not come from a web page
+    void requestStarted(QWebPage* page, QNetworkReply* reply);
+    // exactly one of these follows each requestStarted()
+    void requestFinished(QNetworkReply* reply);
+    void requestDropped(QObject* reply);
+
+protected:
+    QNetworkReply* createRequest(Operation, const QNetworkRequest&, QIODevice* outgoingData);
+
+private Q_SLOTS:
+    void replyDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+    void replyFinished();
+    void replyDestroyed(QObject*);
+    void pageDestroyed(QObject*);
+
+private:
+    Q_DISABLE_COPY(NetworkAccessManager)
+
+    QWebPage* originatingPage(const QNetworkRequest&) const;
+    qint64 estimatedBlockedBytes(int blockedRequests) const;
+    void accountReply(QObject* reply);
+
+    struct PendingReply {
+        PendingReply() : page(0), bytesReceived(0) {}
+        QObject* page;
+        qint64 bytesReceived;
+    };
+    // keyed by QObject so that destroyed replies can be looked up
+    QHash<QObject*, PendingReply> m_pendingReplies;
+    QHash<QObject*, Traffic> m_pageTraffic;
+    Traffic m_totalTraffic;
+    int m_cachedReplies;
+    ContentFilter* m_contentFilter;
+    NetworkTimingLog* m_timingLog;
+};
+
+#endif
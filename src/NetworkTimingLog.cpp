@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "NetworkTimingLog.h"
+
+#include <QFile>
+#include <QTextStream>
+#if !USE_WEBKIT2
+#include <qwebframe.h>
+#include <qwebpage.h>
+#endif
+
+namespace {
+// a page that keeps polling does not grow the log without bounds
+const int s_maxEntriesPerPage = 1000;
+
+QString jsonString(const QString& string)
+{
+    QString result("\"");
+    for (int i = 0; i < string.size(); ++i) {
+        QChar c = string.at(i);
+        if (c == '"' || c == '\\')
+            result += QString('\\') + c;
+        else if (c == '\n')
+            result += "\\n";
+        else if (c == '\r')
+            result += "\\r";
+        else if (c == '\t')
+            result += "\\t";
+        else if (c.unicode() < 0x20)
+            result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+        else
+            result += c;
+    }
+    return result + '"';
+}
+
+QString jsonString(const QByteArray& string)
+{
+    return jsonString(QString::fromLatin1(string));
+}
+
+QString jsonDateTime(const QDateTime& dateTime)
+{
+    return jsonString(dateTime.toUTC().toString("yyyy-MM-dd'T'hh:mm:ss.zzz'Z'"));
+}
+
+QByteArray operationName(QNetworkAccessManager::Operation operation)
+{
+    switch (operation) {
+    case QNetworkAccessManager::HeadOperation:
+        return "HEAD";
+    case QNetworkAccessManager::GetOperation:
+        return "GET";
+    case QNetworkAccessManager::PutOperation:
+        return "PUT";
+    case QNetworkAccessManager::PostOperation:
+        return "POST";
+    case QNetworkAccessManager::DeleteOperation:
+        return "DELETE";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+template<typename HeaderList>
+qint64 headersSize(const HeaderList& headers)
+{
+    qint64 size = 0;
+    foreach (const typename HeaderList::value_type& header, headers)
+        size += header.first.size() + header.second.size() + 4;
+    return size;
+}
+
+template<typename HeaderList>
+void writeHeaders(QTextStream& stream, const HeaderList& headers)
+{
+    stream << "[";
+    for (int i = 0; i < headers.size(); ++i) {
+        stream << (i ? ", " : "") << "{\"name\": " << jsonString(headers.at(i).first)
+               << ", \"value\": " << jsonString(headers.at(i).second) << "}";
+    }
+    stream << "]";
+}
+}
+
+/*! \class NetworkTimingLog records the timing of every request for offline profiling.
+
+  For each page the requests since the start of its latest main frame
+  load are kept: when they started, when the response headers arrived
+  and when they finished, with sizes, headers and whether the cache
+  served them. writeHar() saves the finished requests of the log in the
+  HTTP Archive format, which developer tools and HAR viewers open.
+
+  The network access manager reports when each request is over, the log
+  does not follow the lifetime of the replies itself.
+
+  Qt does not tell when a request waited for a free connection or how
+  long connecting took, so the blocked, dns and connect phases are -1
+  and the wait phase includes them.
+*/
+NetworkTimingLog::NetworkTimingLog(QObject* parent)
+    : QObject(parent)
+{
+    m_clock.start();
+}
+
+void NetworkTimingLog::startPageLog(QWebPage* page)
+{
+    PageLog& pageLog = m_pages[page];
+    // replies of the previous load are not logged any more
+    pageLog.loadId++;
+    pageLog.started = QDateTime::currentDateTime();
+    pageLog.startMS = m_clock.elapsed();
+#if !USE_WEBKIT2
+    pageLog.url = page->mainFrame()->requestedUrl();
+#endif
+    pageLog.entries.clear();
+}
+
+void NetworkTimingLog::requestStarted(QWebPage* page, QNetworkReply* reply)
+{
+    if (!page)
+        return;
+    if (!m_pages.contains(page)) {
+        connect(page, SIGNAL(destroyed(QObject*)), this, SLOT(pageDestroyed(QObject*)));
+#if !USE_WEBKIT2
+        connect(page->mainFrame(), SIGNAL(loadStarted()), this, SLOT(mainFrameLoadStarted()));
+#endif
+        startPageLog(page);
+    }
+    PageLog& pageLog = m_pages[page];
+    if (pageLog.entries.size() >= s_maxEntriesPerPage)
+        return;
+
+    Entry entry;
+    entry.started = QDateTime::currentDateTime();
+    entry.startMS = m_clock.elapsed();
+    entry.method = operationName(reply->operation());
+    entry.url = reply->url();
+    QNetworkRequest request = reply->request();
+    foreach (const QByteArray& name, request.rawHeaderList())
+        entry.requestHeaders.append(qMakePair(name, request.rawHeader(name)));
+    pageLog.entries.append(entry);
+
+    PendingReply pending;
+    pending.page = page;
+    pending.loadId = pageLog.loadId;
+    pending.index = pageLog.entries.size() - 1;
+    m_pendingReplies.insert(reply, pending);
+    connect(reply, SIGNAL(metaDataChanged()), this, SLOT(replyMetaDataChanged()));
+    connect(reply, SIGNAL(downloadProgress(qint64, qint64)), this, SLOT(replyDownloadProgress(qint64, qint64)));
+}
+
+NetworkTimingLog::Entry* NetworkTimingLog::pendingEntry(QObject* reply)
+{
+    QHash<QObject*, PendingReply>::const_iterator pending = m_pendingReplies.constFind(reply);
+    if (pending == m_pendingReplies.constEnd())
+        return 0;
+    QHash<QObject*, PageLog>::iterator page = m_pages.find(pending->page);
+    // the page started another load or went away
+    if (page == m_pages.end() || page->loadId != pending->loadId)
+        return 0;
+    return &page->entries[pending->index];
+}
+
+void NetworkTimingLog::replyMetaDataChanged()
+{
+    Entry* entry = pendingEntry(sender());
+    if (entry && entry->firstByteMS == -1)
+        entry->firstByteMS = m_clock.elapsed();
+}
+
+void NetworkTimingLog::replyDownloadProgress(qint64 bytesReceived, qint64)
+{
+    Entry* entry = pendingEntry(sender());
+    if (!entry)
+        return;
+    if (entry->firstByteMS == -1)
+        entry->firstByteMS = m_clock.elapsed();
+    entry->bodySize = bytesReceived;
+}
+
+void NetworkTimingLog::requestFinished(QNetworkReply* reply)
+{
+    disconnect(reply, 0, this, 0);
+    Entry* entry = pendingEntry(reply);
+    m_pendingReplies.remove(reply);
+    if (!entry)
+        return;
+
+    entry->finishMS = m_clock.elapsed();
+    if (entry->firstByteMS == -1)
+        entry->firstByteMS = entry->finishMS;
+    entry->status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    entry->statusText = reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toString();
+    entry->responseHeaders = reply->rawHeaderPairs();
+    entry->fromCache = reply->attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool();
+}
+
+void NetworkTimingLog::requestDropped(QObject* reply)
+{
+    // the entry stays unfinished and is left out of the HAR
+    m_pendingReplies.remove(reply);
+}
+
+void NetworkTimingLog::mainFrameLoadStarted()
+{
+#if !USE_WEBKIT2
+    // loadStarted comes before the document is requested
+    if (QWebFrame* frame = qobject_cast<QWebFrame*>(sender()))
+        startPageLog(frame->page());
+#endif
+}
+
+void NetworkTimingLog::pageDestroyed(QObject* page)
+{
+    m_pages.remove(page);
+}
+
+bool NetworkTimingLog::writeHar(const QString& filePath) const
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << "{\"log\": {" << endl;
+    stream << "  \"version\": \"1.2\"," << endl;
+    stream << "  \"creator\": {\"name\": \"yberbrowser\", \"version\": \"1.0\"}," << endl;
+
+    QList<QString> pageIds;
+    stream << "  \"pages\": [";
+    QHash<QObject*, PageLog>::const_iterator page = m_pages.constBegin();
+    for (int i = 0; page != m_pages.constEnd(); ++page, ++i) {
+        QString title = page->url.toString();
+#if !USE_WEBKIT2
+        title = static_cast<QWebPage*>(page.key())->mainFrame()->title();
+#endif
+        // the document request finishing stands in for the content load
+        int documentFinishMS = -1;
+        foreach (const Entry& entry, page->entries) {
+            if (entry.url == page->url) {
+                documentFinishMS = entry.finishMS;
+                break;
+            }
+        }
+        pageIds.append(QString("page_%1").arg(i + 1));
+        stream << (i ? "," : "") << endl;
+        stream << "    {\"startedDateTime\": " << jsonDateTime(page->started)
+               << ", \"id\": " << jsonString(pageIds.last())
+               << ", \"title\": " << jsonString(title)
+               << ", \"pageTimings\": {\"onContentLoad\": " << (documentFinishMS == -1 ? -1 : documentFinishMS - page->startMS)
+               << ", \"onLoad\": -1}}";
+    }
+    stream << endl << "  ]," << endl;
+
+    stream << "  \"entries\": [";
+    bool first = true;
+    page = m_pages.constBegin();
+    for (int i = 0; page != m_pages.constEnd(); ++page, ++i) {
+        foreach (const Entry& entry, page->entries) {
+            // HAR has no way to tell a running request, its times must not be negative
+            if (entry.finishMS == -1)
+                continue;
+            stream << (first ? "" : ",") << endl;
+            writeEntry(stream, entry, pageIds.at(i));
+            first = false;
+        }
+    }
+    stream << endl << "  ]" << endl;
+    stream << "}}" << endl;
+    return true;
+}
+
+void NetworkTimingLog::writeEntry(QTextStream& stream, const Entry& entry, const QString& pageId) const
+{
+    int waitMS = entry.firstByteMS - entry.startMS;
+    int receiveMS = entry.finishMS - entry.firstByteMS;
+    int totalMS = entry.finishMS - entry.startMS;
+    QString mimeType;
+    foreach (const QNetworkReply::RawHeaderPair& header, entry.responseHeaders) {
+        if (header.first.toLower() == "content-type")
+            mimeType = QString::fromLatin1(header.second);
+    }
+
+    stream << "    {\"pageref\": " << jsonString(pageId)
+           << ", \"startedDateTime\": " << jsonDateTime(entry.started)
+           << ", \"time\": " << totalMS << "," << endl;
+    stream << "     \"request\": {\"method\": " << jsonString(entry.method)
+           << ", \"url\": " << jsonString(QString::fromLatin1(entry.url.toEncoded()))
+           << ", \"httpVersion\": \"HTTP/1.1\", \"cookies\": [], \"headers\": ";
+    writeHeaders(stream, entry.requestHeaders);
+    stream << ", \"queryString\": [], \"headersSize\": " << headersSize(entry.requestHeaders)
+           << ", \"bodySize\": -1}," << endl;
+    stream << "     \"response\": {\"status\": " << entry.status
+           << ", \"statusText\": " << jsonString(entry.statusText)
+           << ", \"httpVersion\": \"HTTP/1.1\", \"cookies\": [], \"headers\": ";
+    writeHeaders(stream, entry.responseHeaders);
+    stream << ", \"content\": {\"size\": " << entry.bodySize << ", \"mimeType\": " << jsonString(mimeType) << "}"
+           << ", \"redirectURL\": \"\", \"headersSize\": " << headersSize(entry.responseHeaders)
+           << ", \"bodySize\": " << (entry.fromCache ? 0 : entry.bodySize) << "}," << endl;
+    stream << "     \"cache\": {}, \"_fromCache\": " << (entry.fromCache ? "true" : "false") << "," << endl;
+    stream << "     \"timings\": {\"blocked\": -1, \"dns\": -1, \"connect\": -1, \"send\": 0"
+           << ", \"wait\": " << waitMS << ", \"receive\": " << receiveMS << "}}";
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef NetworkTimingLog_h
+#define NetworkTimingLog_h
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QNetworkReply>
+#include <QObject>
+#include <QTime>
+#include <QUrl>
+#include "yberconfig.h"
+
+class QTextStream;
+class QWebPage;
+
+class NetworkTimingLog : public QObject
+{
+    Q_OBJECT
+public:
+    NetworkTimingLog(QObject* parent = 0);
+
+    bool writeHar(const QString& filePath) const;
+
+public Q_SLOTS:
+    void requestStarted(QWebPage*, QNetworkReply*);
+    void requestFinished(QNetworkReply*);
+    void requestDropped(QObject*);
+
+private Q_SLOTS:
+    void replyMetaDataChanged();
+    void replyDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+    void mainFrameLoadStarted();
+    void pageDestroyed(QObject*);
+
+private:
+    Q_DISABLE_COPY(NetworkTimingLog)
+
+    // times are milliseconds on m_clock, -1 when not reached
+    struct Entry {
+        Entry() : startMS(-1), firstByteMS(-1), finishMS(-1), status(0), bodySize(0), fromCache(false) {}
+        QDateTime started;
+        int startMS;
+        int firstByteMS;
+        int finishMS;
+        QByteArray method;
+        QUrl url;
+        QList<QNetworkReply::RawHeaderPair> requestHeaders;
+        int status;
+        QString statusText;
+        QList<QNetworkReply::RawHeaderPair> responseHeaders;
+        qint64 bodySize;
+        bool fromCache;
+    };
+    // the requests of the latest main frame load of a page
+    struct PageLog {
+        PageLog() : loadId(0), startMS(-1) {}
+        int loadId;
+        QDateTime started;
+        int startMS;
+        QUrl url;
+        QList<Entry> entries;
+    };
+    struct PendingReply {
+        QObject* page;
+        int loadId;
+        int index;
+    };
+
+    Entry* pendingEntry(QObject* reply);
+    void writeEntry(QTextStream&, const Entry&, const QString& pageId) const;
+
+    void startPageLog(QWebPage*);
+
+    QTime m_clock;
+    QHash<QObject*, PageLog> m_pages;
+    // until the manager reports the reply finished or dropped, a dropped
+    // one only as the QObject it was
+    QHash<QObject*, PendingReply> m_pendingReplies;
+};
+
+#endif
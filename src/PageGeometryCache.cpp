@@ -0,0 +1,426 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "PageGeometryCache.h"
+
+#if !USE_WEBKIT2
+
+#include <qgraphicswebview.h>
+#include <qwebelement.h>
+#include <qwebframe.h>
+#include <qwebpage.h>
+#include <QSet>
+#include <QTimerEvent>
+
+namespace {
+const char* s_clickableSelector = "a[href], area[href], input, select, textarea, button, [onclick]";
+const int s_cellSize = 128;
+// elements spanning more cells than this are kept out of the grid
+const int s_maxCellsPerElement = 64;
+// layout changes come in bursts while loading
+const int s_rebuildDelayMS = 250;
+
+quint32 cellKey(int column, int row)
+{
+    return (quint32(column & 0xffff) << 16) | quint32(row & 0xffff);
+}
+
+bool isControlTag(const QString& tagName)
+{
+    return tagName == "INPUT" || tagName == "SELECT" || tagName == "TEXTAREA" || tagName == "BUTTON";
+}
+
+// the link an element is nested in, if any
+QWebElement enclosingLink(QWebElement element)
+{
+    for (; !element.isNull(); element = element.parent()) {
+        QString tagName = element.tagName().toUpper();
+        if ((tagName == "A" || tagName == "AREA") && element.hasAttribute("href"))
+            return element;
+    }
+    return QWebElement();
+}
+}
+
+/*! \class PageGeometryCache keeps the geometry of a page's clickable
+  elements so that taps can be targeted without calling into WebKit.
+
+  The clickable elements of each frame are indexed in a grid of
+  s_cellSize cells, in frame coordinates. Each layout or DOM change of a
+  frame starts a new layout generation for it; the frame's index is
+  rebuilt once per generation, when the layout settles. Queries never
+  rebuild. Frame offsets are resolved at query time, so a relayout of one
+  frame does not invalidate the others.
+
+  The index can not see everything: it is empty until the first rebuild,
+  and scrolling an overflow element or a DOM change that keeps the
+  contents size moves elements without a layout change. Where the index
+  is dirty, or has no link at the tap, a single hit test at the tap point
+  decides instead.
+*/
+PageGeometryCache::PageGeometryCache(QGraphicsWebView* webView, QObject* parent)
+    : QObject(parent)
+    , m_webView(webView)
+    , m_page(0)
+    , m_layoutGeneration(0)
+{
+}
+
+PageGeometryCache::~PageGeometryCache()
+{
+    detachFromPage();
+}
+
+void PageGeometryCache::attachToPage()
+{
+    detachFromPage();
+    QWebPage* page = m_webView->page();
+    if (!page)
+        return;
+    m_page = page;
+
+    connect(page, SIGNAL(frameCreated(QWebFrame*)), this, SLOT(frameCreated(QWebFrame*)));
+    connect(page->mainFrame(), SIGNAL(loadStarted()), this, SLOT(mainFrameLoadStarted()));
+
+    QList<QWebFrame*> frames;
+    frames.append(page->mainFrame());
+    while (!frames.isEmpty()) {
+        QWebFrame* frame = frames.takeFirst();
+        watchFrame(frame);
+        frames += frame->childFrames();
+    }
+}
+
+void PageGeometryCache::detachFromPage()
+{
+    m_rebuildTimer.stop();
+    for (int i = 0; i < m_frames.size(); ++i) {
+        if (m_frames.at(i).frame)
+            disconnect(m_frames.at(i).frame, 0, this, 0);
+    }
+    m_frames.clear();
+
+    if (!m_page)
+        return;
+    disconnect(m_page, 0, this, 0);
+    m_page = 0;
+}
+
+void PageGeometryCache::watchFrame(QWebFrame* frame)
+{
+    FrameIndex index;
+    index.frame = frame;
+    m_frames.append(index);
+
+    connect(frame, SIGNAL(initialLayoutCompleted()), this, SLOT(frameLayoutChanged()));
+    connect(frame, SIGNAL(contentsSizeChanged(const QSize&)), this, SLOT(frameLayoutChanged()));
+    connect(frame, SIGNAL(loadFinished(bool)), this, SLOT(frameLayoutChanged()));
+    m_rebuildTimer.start(s_rebuildDelayMS, this);
+}
+
+void PageGeometryCache::frameCreated(QWebFrame* frame)
+{
+    watchFrame(frame);
+}
+
+void PageGeometryCache::frameLayoutChanged()
+{
+    invalidate(qobject_cast<QWebFrame*>(sender()));
+}
+
+void PageGeometryCache::mainFrameLoadStarted()
+{
+    // the subframes of the old document go away with it
+    QWebPage* page = m_webView->page();
+    for (int i = m_frames.size() - 1; i >= 0; --i) {
+        if (m_frames.at(i).frame != page->mainFrame()) {
+            if (m_frames.at(i).frame)
+                disconnect(m_frames.at(i).frame, 0, this, 0);
+            m_frames.removeAt(i);
+        }
+    }
+    invalidate(page->mainFrame());
+}
+
+void PageGeometryCache::invalidate(QWebFrame* frame)
+{
+    for (int i = 0; i < m_frames.size(); ++i) {
+        if (m_frames.at(i).frame == frame) {
+            m_frames[i].layoutGeneration++;
+            m_layoutGeneration++;
+            m_rebuildTimer.start(s_rebuildDelayMS, this);
+            return;
+        }
+    }
+}
+
+void PageGeometryCache::timerEvent(QTimerEvent* ev)
+{
+    if (ev->timerId() == m_rebuildTimer.timerId()) {
+        m_rebuildTimer.stop();
+        rebuildDirtyFrames();
+        return;
+    }
+    QObject::timerEvent(ev);
+}
+
+void PageGeometryCache::pruneDeletedFrames()
+{
+    for (int i = m_frames.size() - 1; i >= 0; --i) {
+        if (!m_frames.at(i).frame)
+            m_frames.removeAt(i);
+    }
+}
+
+void PageGeometryCache::rebuildDirtyFrames()
+{
+    pruneDeletedFrames();
+    for (int i = 0; i < m_frames.size(); ++i) {
+        if (m_frames.at(i).isDirty())
+            rebuild(m_frames[i]);
+    }
+}
+
+void PageGeometryCache::rebuild(FrameIndex& index)
+{
+    index.indexedGeneration = index.layoutGeneration;
+    index.elements.clear();
+    index.cells.clear();
+    index.largeElements.clear();
+
+    QWebElementCollection clickables = index.frame->findAllElements(s_clickableSelector);
+    for (int i = 0; i < clickables.count(); ++i) {
+        const QWebElement& element = clickables.at(i);
+        Element entry;
+        entry.rect = element.geometry();
+        if (entry.rect.isEmpty())
+            continue;
+        QString tagName = element.tagName().toUpper();
+        entry.isLink = tagName == "A" || tagName == "AREA";
+        entry.isControl = entry.isLink || isControlTag(tagName);
+        // a click handler or control inside a link still follows the link
+        QWebElement link = entry.isLink ? element : enclosingLink(element.parent());
+        if (!link.isNull()) {
+            entry.isLink = true;
+            entry.isControl = true;
+            entry.url = index.frame->baseUrl().resolved(QUrl(link.attribute("href")));
+        }
+
+        int elementIndex = index.elements.size();
+        index.elements.append(entry);
+
+        int left = qMax(0, entry.rect.left() / s_cellSize);
+        int right = qMax(0, entry.rect.right() / s_cellSize);
+        int top = qMax(0, entry.rect.top() / s_cellSize);
+        int bottom = qMax(0, entry.rect.bottom() / s_cellSize);
+        if ((right - left + 1) * (bottom - top + 1) > s_maxCellsPerElement) {
+            index.largeElements.append(elementIndex);
+            continue;
+        }
+        for (int row = top; row <= bottom; ++row) {
+            for (int column = left; column <= right; ++column)
+                index.cells[cellKey(column, row)].append(elementIndex);
+        }
+    }
+}
+
+QVector<int> PageGeometryCache::candidates(const FrameIndex& index, const QRect& rect) const
+{
+    QSet<int> found;
+    for (int i = 0; i < index.largeElements.size(); ++i)
+        found.insert(index.largeElements.at(i));
+
+    int left = qMax(0, rect.left() / s_cellSize);
+    int right = qMax(0, rect.right() / s_cellSize);
+    int top = qMax(0, rect.top() / s_cellSize);
+    int bottom = qMax(0, rect.bottom() / s_cellSize);
+    for (int row = top; row <= bottom; ++row) {
+        for (int column = left; column <= right; ++column) {
+            QHash<quint32, QVector<int> >::const_iterator cell = index.cells.constFind(cellKey(column, row));
+            if (cell == index.cells.constEnd())
+                continue;
+            for (int i = 0; i < cell.value().size(); ++i)
+                found.insert(cell.value().at(i));
+        }
+    }
+    return found.toList().toVector();
+}
+
+QPoint PageGeometryCache::frameOffset(QWebFrame* frame) const
+{
+    QPoint offset;
+    for (; frame; frame = frame->parentFrame())
+        offset += frame->pos();
+    return offset;
+}
+
+/*!
+  Finds the point of a clickable element within \a searchRect that is
+  closest to \a pos. Of elements at the same distance the smallest one
+  wins, so that a link beats the clickable container around it.
+*/
+bool PageGeometryCache::findClickablePoint(const QRect& searchRect, const QPoint& pos, QPoint& result)
+{
+    pruneDeletedFrames();
+
+    bool found = false;
+    bool hasDirtyFrames = false;
+    int bestDistance = 0;
+    qint64 bestArea = 0;
+    for (int i = 0; i < m_frames.size(); ++i) {
+        const FrameIndex& index = m_frames.at(i);
+        if (index.isDirty()) {
+            hasDirtyFrames = true;
+            continue;
+        }
+        QPoint offset = frameOffset(index.frame);
+        QRect localSearchRect = searchRect.translated(-offset);
+        QPoint localPos = pos - offset;
+
+        QVector<int> elements = candidates(index, localSearchRect);
+        for (int j = 0; j < elements.size(); ++j) {
+            const QRect& rect = index.elements.at(elements.at(j)).rect;
+            if (!rect.intersects(localSearchRect))
+                continue;
+            QPoint closest(qBound(rect.left(), localPos.x(), rect.right()), qBound(rect.top(), localPos.y(), rect.bottom()));
+            int distance = (closest - localPos).manhattanLength();
+            qint64 area = qint64(rect.width()) * rect.height();
+            if (!found || distance < bestDistance || (distance == bestDistance && area < bestArea)) {
+                found = true;
+                bestDistance = distance;
+                bestArea = area;
+                result = closest + offset;
+            }
+        }
+    }
+    // frames that are not indexed yet are only searched at the point itself
+    Element element;
+    if (hasDirtyFrames && (!found || bestDistance > 0) && hitTestElementAt(pos, element)) {
+        result = pos;
+        return true;
+    }
+    return found;
+}
+
+/*!
+  Returns the smallest clickable element containing \a pos in \a element,
+  with its rect in main frame coordinates. A link found in the index is
+  trusted, anything else is checked with a hit test, as the index may be
+  dirty or stale at \a pos.
+*/
+bool PageGeometryCache::clickableElementAt(const QPoint& pos, Element& element)
+{
+    bool found = indexedElementAt(pos, element);
+    if (found && element.isLink)
+        return true;
+    return hitTestElementAt(pos, element) || found;
+}
+
+/*!
+  Returns the smallest clickable element containing \a pos as far as the
+  index knows, without calling into WebKit. Dirty frames are skipped, so
+  this may miss an element that clickableElementAt() finds.
+*/
+bool PageGeometryCache::indexedElementAt(const QPoint& pos, Element& element)
+{
+    pruneDeletedFrames();
+
+    bool found = false;
+    qint64 bestArea = 0;
+    for (int i = 0; i < m_frames.size(); ++i) {
+        const FrameIndex& index = m_frames.at(i);
+        if (index.isDirty())
+            continue;
+        QPoint offset = frameOffset(index.frame);
+        QPoint localPos = pos - offset;
+
+        QVector<int> elements = candidates(index, QRect(localPos, QSize(1, 1)));
+        for (int j = 0; j < elements.size(); ++j) {
+            const Element& candidate = index.elements.at(elements.at(j));
+            qint64 area = qint64(candidate.rect.width()) * candidate.rect.height();
+            if (!candidate.rect.contains(localPos) || (found && area >= bestArea))
+                continue;
+            found = true;
+            bestArea = area;
+            element = candidate;
+            element.rect.translate(offset);
+        }
+    }
+    return found;
+}
+
+/*!
+  Finds the clickable element at \a pos by a hit test, the way the index
+  would have recorded it. Used where the index can not be trusted.
+*/
+bool PageGeometryCache::hitTestElementAt(const QPoint& pos, Element& element) const
+{
+    QWebPage* page = m_webView->page();
+    if (!page)
+        return false;
+    QWebHitTestResult hit = page->mainFrame()->hitTestContent(pos);
+    if (hit.isNull())
+        return false;
+
+    QWebElement target = hit.linkElement();
+    Element result;
+    if (!target.isNull()) {
+        result.isLink = true;
+        result.isControl = true;
+        result.url = hit.linkUrl();
+    } else {
+        target = hit.element().isNull() ? hit.enclosingBlockElement() : hit.element();
+        for (; !target.isNull(); target = target.parent()) {
+            QString tagName = target.tagName().toUpper();
+            if (isControlTag(tagName))
+                result.isControl = true;
+            if (result.isControl || target.hasAttribute("onclick"))
+                break;
+        }
+        if (target.isNull())
+            return false;
+    }
+    result.rect = target.geometry().translated(frameOffset(target.webFrame()));
+    element = result;
+    return true;
+}
+
+/*!
+  Returns the innermost block at least \a minimumWidth wide that contains
+  \a pos in \a block, in main frame coordinates, the double tap zoom
+  target. It is only needed on a double tap, so it is looked up then by
+  walking up from the hit test element rather than kept in the index.
+*/
+bool PageGeometryCache::findZoomableBlock(const QPoint& pos, int minimumWidth, QRect& block)
+{
+    QWebPage* page = m_webView->page();
+    if (!page)
+        return false;
+
+    QWebElement element = page->mainFrame()->hitTestContent(pos).enclosingBlockElement();
+    while (!element.isNull() && element.geometry().width() < minimumWidth)
+        element = element.parent();
+    if (element.isNull())
+        return false;
+    block = element.geometry().translated(frameOffset(element.webFrame()));
+    return true;
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef PageGeometryCache_h
+#define PageGeometryCache_h
+
+#if !USE_WEBKIT2
+#include <QBasicTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QRect>
+#include <QUrl>
+#include <QVector>
+#include "yberconfig.h"
+
+class QGraphicsWebView;
+class QWebFrame;
+
+class PageGeometryCache : public QObject
+{
+    Q_OBJECT
+public:
+    struct Element {
+        Element() : isLink(false), isControl(false) {}
+        QRect rect;
+        bool isLink;
+        // a link or form control, not just an element with a click handler
+        bool isControl;
+        QUrl url;
+    };
+
+    PageGeometryCache(QGraphicsWebView*, QObject* parent = 0);
+    ~PageGeometryCache();
+
+    void attachToPage();
+    void detachFromPage();
+
+    // positions and rects are in main frame contents coordinates
+    bool findClickablePoint(const QRect& searchRect, const QPoint& pos, QPoint& result);
+    bool clickableElementAt(const QPoint& pos, Element& element);
+    bool indexedElementAt(const QPoint& pos, Element& element);
+    bool findZoomableBlock(const QPoint& pos, int minimumWidth, QRect& block);
+
+    unsigned layoutGeneration() const { return m_layoutGeneration; }
+
+protected:
+    void timerEvent(QTimerEvent*);
+
+private Q_SLOTS:
+    void frameCreated(QWebFrame*);
+    void frameLayoutChanged();
+    void mainFrameLoadStarted();
+
+private:
+    Q_DISABLE_COPY(PageGeometryCache)
+
+    struct FrameIndex {
+        FrameIndex() : layoutGeneration(1), indexedGeneration(0) {}
+        bool isDirty() const { return layoutGeneration != indexedGeneration; }
+        QPointer<QWebFrame> frame;
+        unsigned layoutGeneration;
+        unsigned indexedGeneration;
+        QVector<Element> elements;
+        QHash<quint32, QVector<int> > cells;
+        QVector<int> largeElements;
+    };
+
+    void watchFrame(QWebFrame*);
+    void invalidate(QWebFrame*);
+    void rebuild(FrameIndex&);
+    void rebuildDirtyFrames();
+    void pruneDeletedFrames();
+    bool hitTestElementAt(const QPoint& pos, Element&) const;
+    QPoint frameOffset(QWebFrame*) const;
+    QVector<int> candidates(const FrameIndex&, const QRect& rect) const;
+
+    QGraphicsWebView* m_webView;
+    QObject* m_page;
+    QList<FrameIndex> m_frames;
+    QBasicTimer m_rebuildTimer;
+    unsigned m_layoutGeneration;
+};
+
+#endif
+#endif
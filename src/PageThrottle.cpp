@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "PageThrottle.h"
+
+#if !USE_WEBKIT2
+
+#include "Settings.h"
+
+#include <qgraphicswebview.h>
+#include <qwebframe.h>
+#include <qwebpage.h>
+#include <qwebsettings.h>
+#include <QDebug>
+#include <QTextStream>
+
+//#define ENABLE_PAGE_THROTTLE_DEBUG
+
+namespace {
+QList<PageThrottle*> s_throttles;
+
+// Wraps the timer functions and XMLHttpRequest of a frame before the
+// page's own scripts run. In the foreground the wrappers hand straight
+// through to the native functions, which keep their timing. While
+// throttled, timeouts fire at most once a second, intervals are replaced
+// by chains of such timeouts, and asynchronous requests are held back
+// until the page is shown again; the wall time of the callbacks that run
+// in the background is accounted. Intervals go back to native ones on
+// resume. Ids are those of the native functions, an interval keeps the
+// id of its first native timer. The state lives in the closure, the page
+// only sees a non-enumerable window.__yberThrottle with the calls used
+// from C++.
+const char* s_throttleScript =
+    "(function() {"
+    "  if ('__yberThrottle' in window)"
+    "    return;"
+    "  var throttled = false, minInterval = 1000, backgroundBusyMS = 0, deferred = 0, pending = [], intervals = {};"
+    "  var setTimeout_ = window.setTimeout, setInterval_ = window.setInterval, clearTimeout_ = window.clearTimeout;"
+    "  function timed(fn, args) {"
+    "    if (typeof fn != 'function')"
+    "      fn = new Function(fn);"
+    "    return function() {"
+    "      var start = new Date().getTime();"
+    "      try {"
+    "        fn.apply(window, args);"
+    "      } finally {"
+    "        backgroundBusyMS += new Date().getTime() - start;"
+    "      }"
+    "    };"
+    "  }"
+    "  function chain(interval) {"
+    "    var run = timed(interval.fn, interval.args);"
+    "    function tick() {"
+    "      interval.id = setTimeout_(tick, Math.max(interval.ms || 0, minInterval));"
+    "      run();"
+    "    }"
+    "    interval.id = setTimeout_(tick, Math.max(interval.ms || 0, minInterval));"
+    "  }"
+    "  function start(interval) {"
+    "    interval.id = setInterval_.apply(window, [interval.fn, interval.ms].concat(interval.args));"
+    "  }"
+    "  window.setTimeout = function(fn, ms) {"
+    "    if (!throttled)"
+    "      return setTimeout_.apply(window, arguments);"
+    "    return setTimeout_(timed(fn, Array.prototype.slice.call(arguments, 2)), Math.max(ms || 0, minInterval));"
+    "  };"
+    "  window.setInterval = function(fn, ms) {"
+    "    var interval = { fn: fn, ms: ms, args: Array.prototype.slice.call(arguments, 2) };"
+    "    throttled ? chain(interval) : start(interval);"
+    "    intervals[interval.id] = interval;"
+    "    return interval.id;"
+    "  };"
+    // timeouts and intervals share their ids, either call clears both
+    "  window.clearTimeout = window.clearInterval = function(id) {"
+    "    if (intervals.hasOwnProperty(id)) {"
+    "      clearTimeout_(intervals[id].id);"
+    "      delete intervals[id];"
+    "    } else {"
+    "      clearTimeout_(id);"
+    "    }"
+    "  };"
+    "  var open_ = XMLHttpRequest.prototype.open, send_ = XMLHttpRequest.prototype.send;"
+    "  XMLHttpRequest.prototype.open = function(method, url, async) {"
+    "    Object.defineProperty(this, '__yberAsync', { value: arguments.length < 3 || !!async, writable: true, configurable: true });"
+    "    return open_.apply(this, arguments);"
+    "  };"
+    "  XMLHttpRequest.prototype.send = function() {"
+    "    if (throttled && this.__yberAsync) {"
+    "      deferred++;"
+    "      pending.push([this, arguments]);"
+    "      return;"
+    "    }"
+    "    return send_.apply(this, arguments);"
+    "  };"
+    "  function setThrottled(value) {"
+    "    if (throttled == !!value)"
+    "      return;"
+    "    throttled = !!value;"
+    "    for (var id in intervals) {"
+    "      if (!intervals.hasOwnProperty(id))"
+    "        continue;"
+    "      clearTimeout_(intervals[id].id);"
+    "      throttled ? chain(intervals[id]) : start(intervals[id]);"
+    "    }"
+    "    if (throttled)"
+    "      return;"
+    "    var requests = pending;"
+    "    pending = [];"
+    "    for (var i = 0; i < requests.length; ++i)"
+    "      send_.apply(requests[i][0], requests[i][1]);"
+    "  }"
+    "  Object.defineProperty(window, '__yberThrottle', { value: {"
+    "    setThrottled: setThrottled,"
+    "    backgroundBusyMS: function() { return backgroundBusyMS; },"
+    "    deferred: function() { return deferred; }"
+    "  } });"
+    "})();";
+}
+
+/*! \class PageThrottle keeps a hidden page from competing with the
+  visible one.
+
+  A throttled page runs its script timers at most once a second, holds
+  back its asynchronous XMLHttpRequests, instantiates no new plugins and
+  does not paint tiles. All of it is undone when the page is shown again,
+  and held back requests are sent then.
+
+  Animated images and plugins that already run are not suspended:
+  QtWebKit 2 has no API to pause either, and removing them from the DOM
+  could not be undone. With the tiles frozen their frames are at least
+  not painted.
+
+  QtWebKit has no per page CPU accounting. What is reported is the wall
+  time of the script timer callbacks that ran in the background; event
+  handlers, network callbacks, layout and image decoding are not in it.
+*/
+PageThrottle::PageThrottle(QGraphicsWebView* webView, QObject* parent)
+    : QObject(parent)
+    , m_webView(webView)
+    , m_page(0)
+    , m_throttled(false)
+    , m_backgroundTimeMS(0)
+{
+    s_throttles.append(this);
+}
+
+PageThrottle::~PageThrottle()
+{
+    s_throttles.removeOne(this);
+    detachFromPage();
+}
+
+void PageThrottle::attachToPage()
+{
+    detachFromPage();
+    QWebPage* page = m_webView->page();
+    if (!page)
+        return;
+    m_page = page;
+
+    connect(page, SIGNAL(frameCreated(QWebFrame*)), this, SLOT(frameCreated(QWebFrame*)));
+    foreach (QWebFrame* frame, frames())
+        watchFrame(frame);
+}
+
+void PageThrottle::detachFromPage()
+{
+    if (!m_page)
+        return;
+    foreach (QWebFrame* frame, frames())
+        disconnect(frame, 0, this, 0);
+    disconnect(m_page, 0, this, 0);
+    m_page = 0;
+}
+
+void PageThrottle::frameCreated(QWebFrame* frame)
+{
+    watchFrame(frame);
+}
+
+void PageThrottle::watchFrame(QWebFrame* frame)
+{
+    connect(frame, SIGNAL(javaScriptWindowObjectCleared()), this, SLOT(installThrottle()));
+    frame->evaluateJavaScript(s_throttleScript);
+}
+
+void PageThrottle::installThrottle()
+{
+    QWebFrame* frame = qobject_cast<QWebFrame*>(sender());
+    if (!frame)
+        return;
+    frame->evaluateJavaScript(s_throttleScript);
+    if (m_throttled)
+        frame->evaluateJavaScript("__yberThrottle.setThrottled(true)");
+}
+
+QList<QWebFrame*> PageThrottle::frames() const
+{
+    QList<QWebFrame*> result;
+    if (!m_page)
+        return result;
+    QList<QWebFrame*> pending;
+    pending.append(static_cast<QWebPage*>(m_page)->mainFrame());
+    while (!pending.isEmpty()) {
+        QWebFrame* frame = pending.takeFirst();
+        result.append(frame);
+        pending += frame->childFrames();
+    }
+    return result;
+}
+
+void PageThrottle::setThrottled(bool throttled)
+{
+    if (!Settings::instance()->backgroundThrottlingEnabled())
+        throttled = false;
+    if (m_throttled == throttled || !m_page)
+        return;
+    m_throttled = throttled;
+
+#if defined(ENABLE_PAGE_THROTTLE_DEBUG)
+    qDebug() << __FUNCTION__ << m_webView->url() << throttled;
+#endif
+
+    QWebPage* page = static_cast<QWebPage*>(m_page);
+    if (throttled) {
+        m_throttledTime.start();
+        page->settings()->setAttribute(QWebSettings::PluginsEnabled, false);
+        m_webView->setTiledBackingStoreFrozen(true);
+        foreach (QWebFrame* frame, frames())
+            frame->evaluateJavaScript("if (window.__yberThrottle) __yberThrottle.setThrottled(true)");
+    } else {
+        m_backgroundTimeMS += m_throttledTime.elapsed();
+        page->settings()->resetAttribute(QWebSettings::PluginsEnabled);
+        m_webView->setTiledBackingStoreFrozen(false);
+        foreach (QWebFrame* frame, frames())
+            frame->evaluateJavaScript("if (window.__yberThrottle) __yberThrottle.setThrottled(false)");
+    }
+}
+
+int PageThrottle::sumOverFrames(const QString& expression) const
+{
+    int sum = 0;
+    foreach (QWebFrame* frame, frames())
+        sum += frame->evaluateJavaScript("window.__yberThrottle ? " + expression + " : 0").toInt();
+    return sum;
+}
+
+int PageThrottle::backgroundTimeMS() const
+{
+    return m_backgroundTimeMS + (m_throttled ? m_throttledTime.elapsed() : 0);
+}
+
+int PageThrottle::backgroundScriptTimeMS() const
+{
+    return sumOverFrames("__yberThrottle.backgroundBusyMS()");
+}
+
+int PageThrottle::deferredRequestCount() const
+{
+    return sumOverFrames("__yberThrottle.deferred()");
+}
+
+void PageThrottle::writeSessionReport(QTextStream& stream)
+{
+    stream << "[background tabs]" << endl;
+    stream << "throttling: " << (Settings::instance()->backgroundThrottlingEnabled() ? "on" : "off") << endl;
+    foreach (PageThrottle* throttle, s_throttles) {
+        int backgroundMS = throttle->backgroundTimeMS();
+        if (!backgroundMS)
+            continue;
+        int scriptMS = throttle->backgroundScriptTimeMS();
+        stream << throttle->m_webView->url().host() << (throttle->isThrottled() ? " (background)" : " (active)") << ": "
+               << backgroundMS / 1000 << "s in background, "
+               << scriptMS << "ms wall time in timer callbacks (" << QString::number(100. * scriptMS / backgroundMS, 'f', 2) << "% of background time), "
+               << throttle->deferredRequestCount() << " requests held back" << endl;
+    }
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef PageThrottle_h
+#define PageThrottle_h
+
+#if !USE_WEBKIT2
+#include <QList>
+#include <QObject>
+#include <QTime>
+#include "yberconfig.h"
+
+class QGraphicsWebView;
+class QTextStream;
+class QWebFrame;
+
+class PageThrottle : public QObject
+{
+    Q_OBJECT
+public:
+    PageThrottle(QGraphicsWebView*, QObject* parent = 0);
+    ~PageThrottle();
+
+    void attachToPage();
+    void detachFromPage();
+
+    void setThrottled(bool);
+    bool isThrottled() const { return m_throttled; }
+
+    int backgroundTimeMS() const;
+    int backgroundScriptTimeMS() const;
+    int deferredRequestCount() const;
+
+    static void writeSessionReport(QTextStream&);
+
+private Q_SLOTS:
+    void frameCreated(QWebFrame*);
+    void installThrottle();
+
+private:
+    Q_DISABLE_COPY(PageThrottle)
+
+    void watchFrame(QWebFrame*);
+    QList<QWebFrame*> frames() const;
+    int sumOverFrames(const QString& expression) const;
+
+    QGraphicsWebView* m_webView;
+    QObject* m_page;
+    bool m_throttled;
+    QTime m_throttledTime;
+    int m_backgroundTimeMS;
+};
+#endif
+#endif
@@ -21,14 +21,31 @@
 #include "PannableViewport.h"
 #include "ScrollbarItem.h"
 #include "EventHelpers.h"
+#include "FrameClock.h"
+#include "Settings.h"
 
 #include <QPointF>
 #include <QGraphicsSceneMouseEvent>
 #include <QGraphicsScene>
+#include <QMouseEvent>
+#include <QTextStream>
 
 namespace {
 const unsigned s_scrollsPerSecond = 60;
 const qreal s_axisLockThreshold = .7;
+
+struct PanInputTotals {
+    PanInputTotals()
+        : moveEvents(0), dispatchedMoves(0), positionUpdates(0)
+    {
+    }
+
+    int moveEvents;
+    int dispatchedMoves;
+    int positionUpdates;
+};
+
+PanInputTotals s_panInput;
 }
 
 /*!
@@ -51,6 +68,9 @@ PannableViewport::PannableViewport(QGraphicsItem* parent)
     , m_pannedWidget(0)
     , m_vScrollbar(new ScrollbarItem(Qt::Vertical, this))
     , m_hScrollbar(new ScrollbarItem(Qt::Horizontal, this))
+    , m_hasPendingMove(false)
+    , m_pendingMoveButtons(Qt::NoButton)
+    , m_pendingMoveModifiers(Qt::NoModifier)
 {
 //    setFlag(QGraphicsItem::ItemClipsChildrenToShape, true);
     setFlag(QGraphicsItem::ItemClipsToShape, true);
@@ -59,6 +79,8 @@ PannableViewport::PannableViewport(QGraphicsItem* parent)
     setScrollsPerSecond(s_scrollsPerSecond);
     setOvershootPolicy(YberHack_Qt::QAbstractKineticScroller::OvershootWhenScrollable);
     setAxisLockThreshold(s_axisLockThreshold);
+    // moves are coalesced per frame before they reach the scroller
+    setMotionUpdatesPerSecond(0);
 }
 
 PannableViewport::~PannableViewport()
@@ -74,6 +96,7 @@ void PannableViewport::setPosition(const QPointF& pos)
     QRectF newGeometry = m_pannedWidget->geometry();
 
     if (oldGeometry != newGeometry) {
+        s_panInput.positionUpdates++;
         updateScrollbars();
         emit positionChanged(newGeometry);
     }
@@ -151,6 +174,111 @@ void PannableViewport::stateChanged(YberHack_Qt::QAbstractKineticScroller::State
         emit panningStopped();
 }
 
+/*! \reimp reimplemented from \QAbstractKineticScroller
+
+  Auto scrolling and overshoot advance on the shared frame clock, in step
+  with the rest of the frame's work.
+*/
+bool PannableViewport::startFrameClock()
+{
+    FrameClock::instance()->subscribe(this, SLOT(kineticFrame()));
+    return true;
+}
+
+void PannableViewport::stopFrameClock()
+{
+    FrameClock::instance()->unsubscribe(this, SLOT(kineticFrame()));
+}
+
+void PannableViewport::kineticFrame()
+{
+    frameClockTick();
+}
+
+/*! Feeds mouse events to the scroller.
+
+  While pushing, every move is swallowed anyway, so only the last move of
+  each frame is handed to the scroller. Position, scrollbars and
+  positionChanged() then update once per displayed frame. Other events
+  flush the pending move first so that they see the latest position.
+
+  Move positions are recorded in the InputResampler at their event time,
+  and it provides the position at the frame time when resampling is
+  enabled.
+*/
+bool PannableViewport::filterMouseEvent(QGraphicsSceneMouseEvent* e)
+{
+    if (e->type() == QEvent::GraphicsSceneMousePress)
+        m_inputResampler.reset();
+    if (e->type() == QEvent::GraphicsSceneMousePress || e->type() == QEvent::GraphicsSceneMouseMove)
+        // QGraphicsView sets the widget, synthesized events have none
+        m_inputResampler.addSample(e->screenPos(), m_inputResampler.eventTime(FrameClock::instance()->elapsed(), e->widget()));
+
+    if (e->type() == QEvent::GraphicsSceneMouseMove) {
+        s_panInput.moveEvents++;
+        if (state() == YberHack_Qt::QAbstractKineticScroller::Pushing && (e->buttons() & Qt::LeftButton)) {
+            m_pendingMoveScreenPos = e->screenPos();
+            m_pendingMoveButtons = e->buttons();
+            m_pendingMoveModifiers = e->modifiers();
+            if (!m_hasPendingMove) {
+                m_hasPendingMove = true;
+                FrameClock::instance()->subscribe(this, SLOT(dispatchPendingMove()));
+            }
+            e->accept();
+            return true;
+        }
+        s_panInput.dispatchedMoves++;
+    } else
+        flushPendingMove();
+
+    return handleMouseEvent(e);
+}
+
+void PannableViewport::dispatchPendingMove()
+{
+    if (!m_hasPendingMove)
+        return;
+
+    QPoint screenPos = m_pendingMoveScreenPos;
+    Settings* settings = Settings::instance();
+    if (settings->inputResamplingEnabled())
+        screenPos = m_inputResampler.positionAt(FrameClock::instance()->frameTime(), settings->inputPredictionEnabled()).toPoint();
+
+    // a resampled position trails or leads the latest move, keep ticking until it settles there
+    if (screenPos == m_pendingMoveScreenPos) {
+        m_hasPendingMove = false;
+        FrameClock::instance()->unsubscribe(this, SLOT(dispatchPendingMove()));
+    }
+    dispatchMove(screenPos);
+}
+
+void PannableViewport::flushPendingMove()
+{
+    if (!m_hasPendingMove)
+        return;
+
+    m_hasPendingMove = false;
+    FrameClock::instance()->unsubscribe(this, SLOT(dispatchPendingMove()));
+    dispatchMove(m_pendingMoveScreenPos);
+}
+
+void PannableViewport::dispatchMove(const QPoint& screenPos)
+{
+    s_panInput.dispatchedMoves++;
+    QMouseEvent move(QEvent::MouseMove, QPoint(), screenPos, Qt::NoButton, m_pendingMoveButtons, m_pendingMoveModifiers);
+    handleMouseEvent(&move);
+}
+
+void PannableViewport::writeSessionReport(QTextStream& stream)
+{
+    stream << "[panning input]" << endl;
+    stream << "pointer moves received: " << s_panInput.moveEvents
+           << ", handled by scroller: " << s_panInput.dispatchedMoves << endl;
+    stream << "position updates: " << s_panInput.positionUpdates << endl;
+    stream << "resampling: " << (Settings::instance()->inputResamplingEnabled() ? "on" : "off")
+           << ", prediction: " << (Settings::instance()->inputPredictionEnabled() ? "on" : "off") << endl;
+}
+
 bool PannableViewport::sceneEvent(QEvent* e)
 {
     bool doFilter = false;
@@ -160,7 +288,7 @@ bool PannableViewport::sceneEvent(QEvent* e)
     case QEvent::GraphicsSceneMousePress:
     case QEvent::GraphicsSceneMouseMove:
     case QEvent::GraphicsSceneMouseRelease:
-        doFilter = handleMouseEvent(static_cast<QGraphicsSceneMouseEvent *>(e));
+        doFilter = filterMouseEvent(static_cast<QGraphicsSceneMouseEvent *>(e));
         break;
     default:
         break;
@@ -180,7 +308,7 @@ bool PannableViewport::sceneEventFilter(QGraphicsItem *i, QEvent *e)
     case QEvent::GraphicsSceneMousePress:
     case QEvent::GraphicsSceneMouseMove:
     case QEvent::GraphicsSceneMouseRelease:
-        doFilter = handleMouseEvent(static_cast<QGraphicsSceneMouseEvent *>(e));
+        doFilter = filterMouseEvent(static_cast<QGraphicsSceneMouseEvent *>(e));
         break;
 
     default:
@@ -40,9 +40,12 @@ public:
 #include <QPropertyAnimation>
 
 #include "3rdparty/qabstractkineticscroller.h"
+#include "InputResampler.h"
 
 class ScrollbarItem;
 class QGraphicsItem;
+class QGraphicsSceneMouseEvent;
+class QTextStream;
 
 class PannableViewport : public QGraphicsWidget, private YberHack_Qt::QAbstractKineticScroller
 {
@@ -65,6 +68,8 @@ public:
     void setWidget(QGraphicsWidget*);
     QGraphicsWidget* widget() const { return m_pannedWidget; }
 
+    static void writeSessionReport(QTextStream&);
+
 Q_SIGNALS:
     void panningStopped();
     void positionChanged(const QRectF&);
@@ -73,7 +78,14 @@ protected:
     bool sceneEvent(QEvent* e);
     bool sceneEventFilter(QGraphicsItem *i, QEvent *e);
 
+private Q_SLOTS:
+    void kineticFrame();
+    void dispatchPendingMove();
+
 private:
+    bool filterMouseEvent(QGraphicsSceneMouseEvent*);
+    void flushPendingMove();
+    void dispatchMove(const QPoint& screenPos);
     void updateScrollbars();
 
     QSize viewportSize() const;
@@ -81,6 +93,8 @@ private:
     QPoint scrollPosition() const;
     void setScrollPosition(const QPoint &pos, const QPoint &overShootDelta);
     void stateChanged(YberHack_Qt::QAbstractKineticScroller::State oldState, YberHack_Qt::QAbstractKineticScroller::State newState);
+    bool startFrameClock();
+    void stopFrameClock();
 
 private:
     QGraphicsWidget* m_pannedWidget;
@@ -88,6 +102,12 @@ private:
     ScrollbarItem* m_hScrollbar;
 
     QPointF m_overShootDelta;
+
+    bool m_hasPendingMove;
+    QPoint m_pendingMoveScreenPos;
+    Qt::MouseButtons m_pendingMoveButtons;
+    Qt::KeyboardModifiers m_pendingMoveModifiers;
+    InputResampler m_inputResampler;
 };
 #endif
 
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "PerformanceReport.h"
+#include "Settings.h"
+#include "PannableViewport.h"
+#include "Preconnector.h"
+#include "Prefetcher.h"
+#include "WebViewportItem.h"
+#include "YberApplication.h"
+#if !USE_WEBKIT2
+#include "BackingStoreMetrics.h"
+#include "PageThrottle.h"
+#include "TileMemoryBudget.h"
+#include "WebViewPool.h"
+#endif
+
+#include <QFile>
+#include <QTextStream>
+
+/*! \class PerformanceReport collects the performance counters of the
+  session into a text report in the private directory.
+
+  The report is named after the session start time, so writing it
+  again during the session replaces the earlier version.
+*/
+PerformanceReport::PerformanceReport()
+    : m_sessionStart(QDateTime::currentDateTime())
+{
+    m_sessionTime.start();
+}
+
+PerformanceReport* PerformanceReport::instance()
+{
+    static PerformanceReport* self = 0;
+    if (!self)
+        self = new PerformanceReport;
+    return self;
+}
+
+QString PerformanceReport::filePath() const
+{
+    return Settings::instance()->privatePath() + "perf-" + m_sessionStart.toString("yyyyMMdd-hhmmss") + ".txt";
+}
+
+bool PerformanceReport::write()
+{
+    QFile reportFile(filePath());
+    if (!reportFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream stream(&reportFile);
+    stream << "session started: " << m_sessionStart.toString(Qt::ISODate) << endl;
+    stream << "session length: " << m_sessionTime.elapsed() / 1000 << "s" << endl;
+#if !USE_MEEGOTOUCH
+    stream << endl;
+    PannableViewport::writeSessionReport(stream);
+#endif
+    stream << endl;
+    WebViewportItem::writeSessionReport(stream);
+    stream << endl;
+    YberApplication::instance()->networkAccessManager()->writeReport(stream);
+    stream << endl;
+    Preconnector::instance()->writeReport(stream);
+    stream << endl;
+    Prefetcher::instance()->writeReport(stream);
+#if !USE_WEBKIT2
+    stream << endl;
+    BackingStoreMetrics::writeSessionReport(stream);
+    stream << endl;
+    TileMemoryBudget::instance()->writeReport(stream);
+    stream << endl;
+    PageThrottle::writeSessionReport(stream);
+    stream << endl;
+    WebViewPool::writeSessionReport(stream);
+#endif
+    return true;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef PerformanceReport_h
+#define PerformanceReport_h
+
+#include <QDateTime>
+#include <QString>
+#include <QTime>
+#include "yberconfig.h"
+
+class PerformanceReport
+{
+public:
+    static PerformanceReport* instance();
+
+    QString filePath() const;
+    bool write();
+
+private:
+    PerformanceReport();
+    Q_DISABLE_COPY(PerformanceReport)
+
+    QDateTime m_sessionStart;
+    QTime m_sessionTime;
+};
+
+#endif
@@ -24,6 +24,7 @@
 #include "TileContainerWidget.h"
 #include "PannableViewport.h"
 #include "WebView.h"
+#include "YberApplication.h"
 
 #include <QPen>
 #include <QTimer>
@@ -60,6 +61,7 @@ Suggest::Suggest()
     : m_loading(false)
 {
 #if !USE_WEBKIT2
+    m_view.page()->setNetworkAccessManager(YberApplication::instance()->networkAccessManager());
     connect(&m_view, SIGNAL(loadFinished(bool)), this, SLOT(loadFinished(bool)));    
 #endif
 }
@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "Preconnector.h"
+#include "BookmarkStore.h"
+#include "FrameClock.h"
+#include "HistoryStore.h"
+#include "Settings.h"
+#include "YberApplication.h"
+
+#include <QHostInfo>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTextStream>
+#include <QTimerEvent>
+
+//#define ENABLE_PRECONNECT_DEBUG
+
+namespace {
+const int s_maxLookupsInFlight = 4;
+const int s_maxPreconnectsInFlight = 2;
+const int s_maxPendingHosts = 8;
+// servers close idle connections after a while, and lookups are cached for a minute
+const int s_warmHostLifetimeMS = 30000;
+const int s_frequentHostCount = 3;
+const int s_frequentHostsDelayMS = 1500;
+}
+
+/*! \class Preconnector resolves and connects to hosts before they are needed.
+
+  Hosts the user is likely to load next are looked up, which fills the
+  host lookup cache, and then connected to with a HEAD request on the
+  shared network stack, which leaves an open connection in its pool.
+  Only a few lookups and connections run at a time; more requests wait
+  in a short queue and the oldest are dropped.
+
+  A warmed host that a page loads from within the lifetime of the
+  connection counts as a hit, one that expires unused as waste. A page
+  load that comes before the host lookup has finished gained nothing and
+  counts as late.
+*/
+Preconnector::Preconnector()
+    : m_lookupsInFlight(0)
+    , m_preconnectsInFlight(0)
+    , m_issuingPreconnect(false)
+    , m_lookups(0)
+    , m_preconnects(0)
+    , m_dropped(0)
+    , m_hits(0)
+    , m_late(0)
+    , m_cancelled(0)
+    , m_wasted(0)
+{
+    connect(YberApplication::instance()->networkAccessManager(), SIGNAL(requestStarted(QWebPage*, QNetworkReply*)),
+            this, SLOT(requestStarted(QWebPage*, QNetworkReply*)));
+}
+
+Preconnector* Preconnector::instance()
+{
+    static Preconnector* self = 0;
+    if (!self)
+        self = new Preconnector;
+    return self;
+}
+
+void Preconnector::warmUp(const QUrl& url)
+{
+    if (!Settings::instance()->preconnectEnabled())
+        return;
+    QString scheme = url.scheme();
+    if (url.host().isEmpty() || (scheme != "http" && scheme != "https"))
+        return;
+
+    expireWarmHosts();
+    QString host = url.host();
+    if (m_warmHosts.contains(host) || m_pendingHosts.contains(host))
+        return;
+
+    WarmHost& warmHost = m_warmHosts[host];
+    warmHost.origin.setScheme(scheme);
+    warmHost.origin.setHost(host);
+    warmHost.origin.setPort(url.port());
+    warmHost.origin.setPath("/");
+    warmHost.warmedTime.start();
+
+    m_pendingHosts.append(host);
+    if (m_pendingHosts.size() > s_maxPendingHosts) {
+        m_warmHosts.remove(m_pendingHosts.takeFirst());
+        m_dropped++;
+    }
+    startPending();
+}
+
+/*!
+  Drops the warm up of the host of \a url unless it has connected or
+  been used already, as for a press that turned into a pan. A lookup
+  that is running completes, but no connection follows it.
+*/
+void Preconnector::cancel(const QUrl& url)
+{
+    QHash<QString, WarmHost>::iterator it = m_warmHosts.find(url.host());
+    if (it == m_warmHosts.end() || it->preconnected || it->used)
+        return;
+    m_pendingHosts.removeOne(url.host());
+    m_warmHosts.erase(it);
+    m_cancelled++;
+}
+
+void Preconnector::startPending()
+{
+    while (!m_pendingHosts.isEmpty() && m_lookupsInFlight < s_maxLookupsInFlight) {
+        QString host = m_pendingHosts.takeFirst();
+#if defined(ENABLE_PRECONNECT_DEBUG)
+        qDebug() << __FUNCTION__ << host;
+#endif
+        m_lookupsInFlight++;
+        m_lookups++;
+        m_warmHosts[host].lookupId = QHostInfo::lookupHost(host, this, SLOT(hostLookedUp(QHostInfo)));
+    }
+}
+
+void Preconnector::hostLookedUp(const QHostInfo& info)
+{
+    m_lookupsInFlight--;
+    startPending();
+
+    QHash<QString, WarmHost>::iterator it = m_warmHosts.find(info.hostName());
+    if (it == m_warmHosts.end() || it->lookupId != info.lookupId())
+        return;
+    it->lookupId = -1;
+    // a page may have started loading from the host already
+    if (info.error() != QHostInfo::NoError || it->used || m_preconnectsInFlight >= s_maxPreconnectsInFlight)
+        return;
+
+    QNetworkRequest request(it->origin);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::AlwaysNetwork);
+    request.setAttribute(QNetworkRequest::CacheSaveControlAttribute, false);
+#if QT_VERSION >= QT_VERSION_CHECK(4, 7, 0)
+    // a warm up is no visit, it sends no cookies and stores none
+    request.setAttribute(QNetworkRequest::CookieLoadControlAttribute, QNetworkRequest::Manual);
+    request.setAttribute(QNetworkRequest::CookieSaveControlAttribute, QNetworkRequest::Manual);
+#endif
+    m_issuingPreconnect = true;
+    QNetworkReply* reply = YberApplication::instance()->networkAccessManager()->head(request);
+    m_issuingPreconnect = false;
+    connect(reply, SIGNAL(finished()), this, SLOT(preconnectFinished()));
+    it->preconnected = true;
+    m_preconnectsInFlight++;
+    m_preconnects++;
+}
+
+void Preconnector::preconnectFinished()
+{
+    m_preconnectsInFlight--;
+    sender()->deleteLater();
+}
+
+void Preconnector::requestStarted(QWebPage* page, QNetworkReply* reply)
+{
+    if (m_issuingPreconnect || !page)
+        return;
+    QHash<QString, WarmHost>::iterator it = m_warmHosts.find(reply->url().host());
+    if (it == m_warmHosts.end() || it->used)
+        return;
+    if (it->warmedTime.elapsed() > s_warmHostLifetimeMS)
+        return;
+    it->used = true;
+    if (it->lookupId != -1 || m_pendingHosts.contains(it.key()))
+        m_late++;
+    else
+        m_hits++;
+}
+
+void Preconnector::expireWarmHosts()
+{
+    QHash<QString, WarmHost>::iterator it = m_warmHosts.begin();
+    while (it != m_warmHosts.end()) {
+        if (it->warmedTime.elapsed() <= s_warmHostLifetimeMS || it->lookupId != -1) {
+            ++it;
+            continue;
+        }
+        if (!it->used)
+            m_wasted++;
+        it = m_warmHosts.erase(it);
+    }
+}
+
+/*!
+  Warms up the hosts the user visits most once nothing is animating,
+  for when the user is about to pick a page to load.
+*/
+void Preconnector::warmUpFrequentHostsSoon()
+{
+    m_frequentHostsTimer.start(s_frequentHostsDelayMS, this);
+}
+
+void Preconnector::timerEvent(QTimerEvent* ev)
+{
+    if (ev->timerId() != m_frequentHostsTimer.timerId()) {
+        QObject::timerEvent(ev);
+        return;
+    }
+    if (FrameClock::instance()->isTicking())
+        return;
+    m_frequentHostsTimer.stop();
+
+    // the history is sorted by use count, most used first
+    QList<QUrl> urls;
+    QStringList hosts;
+    const UrlList& history = HistoryStore::instance()->list();
+    for (int i = 0; i < history.size() && hosts.size() < s_frequentHostCount; ++i) {
+        if (!hosts.contains(history.at(i).url().host())) {
+            hosts.append(history.at(i).url().host());
+            urls.append(history.at(i).url());
+        }
+    }
+    const UrlList& bookmarks = BookmarkStore::instance()->list();
+    for (int i = 0; i < bookmarks.size() && hosts.size() < 2 * s_frequentHostCount; ++i) {
+        if (!hosts.contains(bookmarks.at(i).url().host())) {
+            hosts.append(bookmarks.at(i).url().host());
+            urls.append(bookmarks.at(i).url());
+        }
+    }
+    foreach (const QUrl& url, urls)
+        warmUp(url);
+}
+
+void Preconnector::writeReport(QTextStream& stream) const
+{
+    int wasted = m_wasted;
+    foreach (const WarmHost& warmHost, m_warmHosts) {
+        if (!warmHost.used && warmHost.warmedTime.elapsed() > s_warmHostLifetimeMS)
+            wasted++;
+    }
+    stream << "[preconnect]" << endl;
+    stream << "lookups: " << m_lookups << endl;
+    stream << "preconnects: " << m_preconnects << endl;
+    stream << "dropped from queue: " << m_dropped << endl;
+    stream << "hits: " << m_hits << endl;
+    stream << "too late: " << m_late << endl;
+    stream << "cancelled: " << m_cancelled << endl;
+    stream << "wasted: " << wasted << endl;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef Preconnector_h
+#define Preconnector_h
+
+#include <QBasicTimer>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTime>
+#include <QUrl>
+#include "yberconfig.h"
+
+class QHostInfo;
+class QNetworkReply;
+class QTextStream;
+class QWebPage;
+
+class Preconnector : public QObject
+{
+    Q_OBJECT
+public:
+    static Preconnector* instance();
+
+    void warmUp(const QUrl&);
+    void cancel(const QUrl&);
+    void warmUpFrequentHostsSoon();
+
+    void writeReport(QTextStream&) const;
+
+protected:
+    void timerEvent(QTimerEvent*);
+
+private Q_SLOTS:
+    void hostLookedUp(const QHostInfo&);
+    void preconnectFinished();
+    void requestStarted(QWebPage*, QNetworkReply*);
+
+private:
+    Preconnector();
+    Q_DISABLE_COPY(Preconnector)
+
+    struct WarmHost {
+        WarmHost() : lookupId(-1), preconnected(false), used(false) {}
+        QUrl origin;
+        int lookupId;
+        bool preconnected;
+        bool used;
+        QTime warmedTime;
+    };
+
+    void startPending();
+    void expireWarmHosts();
+
+    QHash<QString, WarmHost> m_warmHosts;
+    QStringList m_pendingHosts;
+    int m_lookupsInFlight;
+    int m_preconnectsInFlight;
+    bool m_issuingPreconnect;
+    QBasicTimer m_frequentHostsTimer;
+
+    int m_lookups;
+    int m_preconnects;
+    int m_dropped;
+    int m_hits;
+    int m_late;
+    int m_cancelled;
+    int m_wasted;
+};
+
+#endif
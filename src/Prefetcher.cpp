@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "Prefetcher.h"
+#include "Settings.h"
+#include "YberApplication.h"
+
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTextStream>
+#include <QTimerEvent>
+
+//#define ENABLE_PREFETCH_DEBUG
+
+namespace {
+const int s_maxPrefetchesInFlight = 2;
+// documents only, anything larger is aborted
+const qint64 s_maxPrefetchBytes = 256 * 1024;
+const qint64 s_sessionPrefetchBudgetBytes = 4 * 1024 * 1024;
+// how long the navigation may take to follow before the prefetch is dropped
+const int s_prefetchLifetimeMS = 3000;
+const int s_typingPauseMS = 600;
+const int s_expiryCheckIntervalMS = 500;
+
+QUrl withoutFragment(const QUrl& url)
+{
+    QUrl result(url);
+    result.setFragment(QString());
+    return result;
+}
+}
+
+/*! \class Prefetcher loads documents into the disk cache before they are navigated to.
+
+  A pressed link is fetched from the press on, which with fast tap gives
+  it the time until the finger lifts and with fast tap off also the link
+  selection delay. A typed address waits for the user to accept it.
+  Meanwhile the document is fetched through the shared network stack so
+  that the navigation finds it in the cache.
+  Only a couple of prefetches run at a time, each is cut off at a size
+  limit and the session has a byte budget. A prefetch that the
+  navigation does not follow shortly is aborted or, if it completed,
+  counted as wasted.
+*/
+Prefetcher::Prefetcher()
+    : m_sessionBytes(0)
+    , m_started(0)
+    , m_completed(0)
+    , m_used(0)
+    , m_late(0)
+    , m_cancelled(0)
+    , m_wasted(0)
+    , m_overBudget(0)
+    , m_wastedBytes(0)
+    , m_receivedBytes(0)
+{
+    connect(YberApplication::instance()->networkAccessManager(), SIGNAL(requestStarted(QWebPage*, QNetworkReply*)),
+            this, SLOT(requestStarted(QWebPage*, QNetworkReply*)));
+}
+
+Prefetcher* Prefetcher::instance()
+{
+    static Prefetcher* self = 0;
+    if (!self)
+        self = new Prefetcher;
+    return self;
+}
+
+void Prefetcher::prefetch(const QUrl& target)
+{
+    QUrl url = withoutFragment(target);
+    if (!Settings::instance()->preconnectEnabled() || !YberApplication::instance()->networkAccessManager()->cache())
+        return;
+    if (url.scheme() != "http" && url.scheme() != "https")
+        return;
+
+    expirePrefetches();
+    if (indexOf(url) != -1)
+        return;
+    if (inFlightCount() >= s_maxPrefetchesInFlight || m_sessionBytes + s_maxPrefetchBytes > s_sessionPrefetchBudgetBytes) {
+        m_overBudget++;
+        return;
+    }
+
+#if defined(ENABLE_PREFETCH_DEBUG)
+    qDebug() << __FUNCTION__ << url;
+#endif
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::CacheLoadControlAttribute, QNetworkRequest::PreferCache);
+    Prefetch prefetch;
+    prefetch.url = url;
+    prefetch.reply = YberApplication::instance()->networkAccessManager()->get(request);
+    prefetch.startTime.start();
+    connect(prefetch.reply, SIGNAL(downloadProgress(qint64, qint64)), this, SLOT(prefetchDownloadProgress(qint64, qint64)));
+    connect(prefetch.reply, SIGNAL(finished()), this, SLOT(prefetchFinished()));
+    m_prefetches.append(prefetch);
+    m_started++;
+    // the whole limit is reserved until the size is known
+    m_sessionBytes += s_maxPrefetchBytes;
+    m_expiryTimer.start(s_expiryCheckIntervalMS, this);
+}
+
+/*!
+  Prefetches \a url, the address the user is typing, once typing has
+  paused. The prefetch of an earlier address is dropped.
+*/
+void Prefetcher::prefetchAfterTypingPause(const QUrl& url)
+{
+    if (url == m_typedUrl)
+        return;
+    if (!m_typedPrefetchUrl.isEmpty())
+        cancel(m_typedPrefetchUrl);
+    m_typedPrefetchUrl = QUrl();
+    m_typedUrl = url;
+    m_typingPauseTimer.start(s_typingPauseMS, this);
+}
+
+void Prefetcher::cancel(const QUrl& url)
+{
+    int index = indexOf(withoutFragment(url));
+    if (index == -1)
+        return;
+    if (m_prefetches.at(index).reply) {
+        m_cancelled++;
+        abort(index);
+    } else {
+        m_wasted++;
+        m_wastedBytes += m_prefetches.at(index).bytesReceived;
+        m_prefetches.removeAt(index);
+    }
+}
+
+int Prefetcher::indexOf(const QUrl& url) const
+{
+    for (int i = 0; i < m_prefetches.size(); ++i) {
+        if (m_prefetches.at(i).url == url)
+            return i;
+    }
+    return -1;
+}
+
+int Prefetcher::inFlightCount() const
+{
+    int count = 0;
+    foreach (const Prefetch& prefetch, m_prefetches) {
+        if (prefetch.reply)
+            count++;
+    }
+    return count;
+}
+
+void Prefetcher::abort(int index)
+{
+    Prefetch prefetch = m_prefetches.takeAt(index);
+    disconnect(prefetch.reply, 0, this, 0);
+    prefetch.reply->abort();
+    prefetch.reply->deleteLater();
+    // give back the part of the reservation that was not used
+    m_sessionBytes -= s_maxPrefetchBytes - prefetch.bytesReceived;
+    m_wastedBytes += prefetch.bytesReceived;
+}
+
+void Prefetcher::prefetchDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
+{
+    int index = 0;
+    while (index < m_prefetches.size() && m_prefetches.at(index).reply != sender())
+        index++;
+    if (index == m_prefetches.size())
+        return;
+
+    m_receivedBytes += bytesReceived - m_prefetches.at(index).bytesReceived;
+    m_prefetches[index].bytesReceived = bytesReceived;
+    if (bytesReceived > s_maxPrefetchBytes || bytesTotal > s_maxPrefetchBytes) {
+        m_overBudget++;
+        abort(index);
+    }
+}
+
+void Prefetcher::prefetchFinished()
+{
+    QNetworkReply* reply = static_cast<QNetworkReply*>(sender());
+    reply->deleteLater();
+    int index = 0;
+    while (index < m_prefetches.size() && m_prefetches.at(index).reply != reply)
+        index++;
+    if (index == m_prefetches.size())
+        return;
+
+    Prefetch& prefetch = m_prefetches[index];
+    m_sessionBytes -= s_maxPrefetchBytes - prefetch.bytesReceived;
+    if (reply->error() != QNetworkReply::NoError) {
+        m_wastedBytes += prefetch.bytesReceived;
+        m_prefetches.removeAt(index);
+        return;
+    }
+    m_completed++;
+    prefetch.reply = 0;
+}
+
+void Prefetcher::requestStarted(QWebPage* page, QNetworkReply* reply)
+{
+    if (!page)
+        return;
+    int index = indexOf(withoutFragment(reply->url()));
+    if (index == -1)
+        return;
+
+    if (m_prefetches.at(index).reply) {
+        // the page loads it anyway, do not download it twice
+        m_late++;
+        abort(index);
+        return;
+    }
+    m_used++;
+    m_prefetches.removeAt(index);
+}
+
+void Prefetcher::expirePrefetches()
+{
+    for (int i = m_prefetches.size() - 1; i >= 0; --i) {
+        if (m_prefetches.at(i).startTime.elapsed() > s_prefetchLifetimeMS)
+            cancel(m_prefetches.at(i).url);
+    }
+    if (m_prefetches.isEmpty())
+        m_expiryTimer.stop();
+}
+
+void Prefetcher::timerEvent(QTimerEvent* ev)
+{
+    if (ev->timerId() == m_expiryTimer.timerId()) {
+        expirePrefetches();
+        return;
+    }
+    if (ev->timerId() == m_typingPauseTimer.timerId()) {
+        m_typingPauseTimer.stop();
+        m_typedPrefetchUrl = withoutFragment(m_typedUrl);
+        prefetch(m_typedUrl);
+        return;
+    }
+    QObject::timerEvent(ev);
+}
+
+void Prefetcher::writeReport(QTextStream& stream) const
+{
+    stream << "[prefetch]" << endl;
+    stream << "started: " << m_started << endl;
+    stream << "completed: " << m_completed << endl;
+    stream << "used: " << m_used << endl;
+    stream << "overtaken by the navigation: " << m_late << endl;
+    stream << "cancelled: " << m_cancelled << endl;
+    stream << "not navigated to: " << m_wasted << endl;
+    stream << "skipped or cut off by budget: " << m_overBudget << endl;
+    stream << "bytes spent: " << m_receivedBytes / 1024 << "kB of " << s_sessionPrefetchBudgetBytes / 1024 << "kB" << endl;
+    stream << "bytes wasted: " << m_wastedBytes / 1024 << "kB" << endl;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef Prefetcher_h
+#define Prefetcher_h
+
+#include <QBasicTimer>
+#include <QList>
+#include <QObject>
+#include <QTime>
+#include <QUrl>
+#include "yberconfig.h"
+
+class QNetworkReply;
+class QTextStream;
+class QWebPage;
+
+class Prefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    static Prefetcher* instance();
+
+    void prefetch(const QUrl&);
+    void prefetchAfterTypingPause(const QUrl&);
+    void cancel(const QUrl&);
+
+    void writeReport(QTextStream&) const;
+
+protected:
+    void timerEvent(QTimerEvent*);
+
+private Q_SLOTS:
+    void prefetchDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+    void prefetchFinished();
+    void requestStarted(QWebPage*, QNetworkReply*);
+
+private:
+    Prefetcher();
+    Q_DISABLE_COPY(Prefetcher)
+
+    struct Prefetch {
+        Prefetch() : reply(0), bytesReceived(0) {}
+        QUrl url;
+        // 0 once the document is in the cache
+        QNetworkReply* reply;
+        qint64 bytesReceived;
+        QTime startTime;
+    };
+
+    int indexOf(const QUrl&) const;
+    int inFlightCount() const;
+    void abort(int index);
+    void expirePrefetches();
+
+    QList<Prefetch> m_prefetches;
+    QUrl m_typedUrl;
+    QUrl m_typedPrefetchUrl;
+    QBasicTimer m_typingPauseTimer;
+    QBasicTimer m_expiryTimer;
+    qint64 m_sessionBytes;
+
+    int m_started;
+    int m_completed;
+    int m_used;
+    int m_late;
+    int m_cancelled;
+    int m_wasted;
+    int m_overBudget;
+    qint64 m_wastedBytes;
+    // what actually came in, m_sessionBytes also holds the reservations of running prefetches
+    qint64 m_receivedBytes;
+};
+
+#endif
@@ -50,6 +50,31 @@ public:
     void enableTileCache(bool enable) { m_tilingEnabled = enable; }
     bool tileCacheEnabled() const { return m_tilingEnabled; }
 
+    void enableTileStoreTuning(bool enable) { m_tileStoreTuningEnabled = enable; }
+    bool tileStoreTuningEnabled() const { return m_tileStoreTuningEnabled; }
+
+    void enableProgressivePanUpdates(bool enable) { m_progressivePanUpdatesEnabled = enable; }
+    bool progressivePanUpdatesEnabled() const { return m_progressivePanUpdatesEnabled; }
+
+    void enableInputResampling(bool enable) { m_inputResamplingEnabled = enable; }
+    bool inputResamplingEnabled() const { return m_inputResamplingEnabled; }
+
+    void enableInputPrediction(bool enable) { m_inputPredictionEnabled = enable; }
+    bool inputPredictionEnabled() const { return m_inputPredictionEnabled; }
+
+    void enableFastTap(bool enable) { m_fastTapEnabled = enable; }
+    bool fastTapEnabled() const { return m_fastTapEnabled; }
+
+    void enableBackgroundThrottling(bool enable) { m_backgroundThrottlingEnabled = enable; }
+    bool backgroundThrottlingEnabled() const { return m_backgroundThrottlingEnabled; }
+
+    void enablePreconnect(bool enable) { m_preconnectEnabled = enable; }
+    bool preconnectEnabled() const { return m_preconnectEnabled; }
+
+    // 0 disables the disk cache
+    void setDiskCacheSize(qint64 bytes) { m_diskCacheSize = bytes; }
+    qint64 diskCacheSize() const { return m_diskCacheSize; }
+
     void setPrivatePath(QString& path) { m_privatePath = path; }
     QString privatePath() const { return m_privatePath; }
 
@@ -57,6 +82,12 @@ public:
     bool isFullScreen() const { return m_isFullScreen; }
 
     QString cookieFilePath() const { return privatePath() + "cookies.dat"; }
+    QString tileStoreTuningLogFilePath() const { return privatePath() + "tiletuning.log"; }
+    QString sessionFilePath() const { return privatePath() + "session.dat"; }
+    QString diskCacheDirectory() const { return privatePath() + "cache"; }
+    QString diskCacheUseFilePath() const { return privatePath() + "cacheuse.dat"; }
+    QString contentFilterFilePath() const { return privatePath() + "filters.txt"; }
+    QString networkLogFilePath() const { return privatePath() + "network.har"; }
 
 private:
     Settings() {
@@ -66,6 +97,14 @@ private:
         m_showFPS = false;
         m_autoCompleteEnabled = true;
         m_tilingEnabled = true;
+        m_tileStoreTuningEnabled = true;
+        m_progressivePanUpdatesEnabled = true;
+        m_inputResamplingEnabled = false;
+        m_inputPredictionEnabled = false;
+        m_fastTapEnabled = true;
+        m_backgroundThrottlingEnabled = true;
+        m_preconnectEnabled = true;
+        m_diskCacheSize = 50 * 1024 * 1024;
 #if defined(Q_WS_MAEMO_5) || defined(Q_OS_SYMBIAN) || USE_MEEGOTOUCH
         m_isFullScreen = true;
 #else
@@ -79,6 +118,14 @@ private:
     bool m_showFPS;
     bool m_autoCompleteEnabled;
     bool m_tilingEnabled;
+    bool m_tileStoreTuningEnabled;
+    bool m_progressivePanUpdatesEnabled;
+    bool m_inputResamplingEnabled;
+    bool m_inputPredictionEnabled;
+    bool m_fastTapEnabled;
+    bool m_backgroundThrottlingEnabled;
+    bool m_preconnectEnabled;
+    qint64 m_diskCacheSize;
     QString m_privatePath;
     bool m_isFullScreen;
 };
@@ -204,7 +204,7 @@ TabWidget::TabWidget(QGraphicsItem* parent, Qt::WindowFlags wFlags)
 
 void TabWidget::layoutTiles()
 {
-    // 6 tabs max atm
+    // a screen holds 6 tabs, more rows extend the container which then pans
     bool landscape = parentWidget()->size().width() > parentWidget()->size().height();
     QRectF r(rect());
     // FIXME work out some proportional thing here as this 2xmargin works 
@@ -213,7 +213,7 @@ void TabWidget::layoutTiles()
     r.setTop(r.top() + tileTopVMargin() - marginY);
     int hTileNum = landscape ? 3 : 2;
     int vTileNum = landscape ? 2 : 3;
-    doLayoutTiles(r, hTileNum, vTileNum, s_tileMargin, marginY);
+    setMinimumHeight(doLayoutTiles(r, hTileNum, vTileNum, s_tileMargin, marginY).height() + s_containerYBottomMargin);
 }
 
 void TabWidget::removeTile(const TileItem& removed)
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "TileMemoryBudget.h"
+
+#if !USE_WEBKIT2
+
+#include "BackingStoreMetrics.h"
+#include "PageThrottle.h"
+#include "TileStoreTuner.h"
+#include "WebView.h"
+
+#include <qwebpage.h>
+#include <qwebsettings.h>
+#include <QTextStream>
+#include <QTimerEvent>
+
+//#define ENABLE_TILE_MEMORY_BUDGET_DEBUG
+
+namespace {
+const qint64 s_tileMemoryBudgetBytes = 24 * 1024 * 1024;
+const int s_enforceIntervalMS = 2000;
+// long enough for the backing store to run its tile creation timer
+const int s_hiddenTileUpdateMS = 500;
+}
+
+/*! \class TileMemoryBudget keeps the backing stores of all tabs within
+  a global memory budget.
+
+  Views are kept in most recently used order. The active view keeps its
+  tuned settings. Background views shrink their keep and cover areas to
+  the visible area, and the least recently used of them lose their
+  tiles altogether, by turning the backing store of the page off, until
+  the total fits the budget. A view gets its tiles back lazily when it
+  is activated again.
+
+  A hidden view has its backing store frozen by its PageThrottle, and a
+  frozen backing store does not apply new keep and cover areas. It is
+  thawed for a moment when its mode changes so that it gets to drop the
+  tiles outside the visible area.
+*/
+TileMemoryBudget::TileMemoryBudget()
+    : m_peakTileMemoryBytes(0)
+    , m_tileDropCount(0)
+{
+}
+
+TileMemoryBudget* TileMemoryBudget::instance()
+{
+    static TileMemoryBudget* self = 0;
+    if (!self)
+        self = new TileMemoryBudget;
+    return self;
+}
+
+void TileMemoryBudget::activate(WebView* view)
+{
+    if (!m_views.removeOne(view)) {
+        m_viewsByObject.insert(view, view);
+        connect(view, SIGNAL(destroyed(QObject*)), this, SLOT(viewDestroyed(QObject*)));
+    }
+    m_views.prepend(view);
+
+    if (m_views.count() > 1 && !m_enforceTimer.isActive())
+        m_enforceTimer.start(s_enforceIntervalMS, this);
+    enforce();
+}
+
+void TileMemoryBudget::viewDestroyed(QObject* object)
+{
+    // the pointer is only a key, the view is already gone
+    WebView* view = m_viewsByObject.take(object);
+    m_views.removeOne(view);
+    m_viewsWithoutTiles.remove(view);
+    m_viewsUpdatingTiles.remove(view);
+    if (m_views.count() < 2)
+        m_enforceTimer.stop();
+}
+
+void TileMemoryBudget::timerEvent(QTimerEvent* ev)
+{
+    if (ev->timerId() == m_enforceTimer.timerId()) {
+        enforce();
+        return;
+    }
+    if (ev->timerId() == m_refreezeTimer.timerId()) {
+        m_refreezeTimer.stop();
+        foreach (WebView* view, m_viewsUpdatingTiles) {
+            if (view->pageThrottle()->isThrottled())
+                view->setTiledBackingStoreFrozen(true);
+        }
+        m_viewsUpdatingTiles.clear();
+        return;
+    }
+    QObject::timerEvent(ev);
+}
+
+qint64 TileMemoryBudget::totalTileMemoryBytes() const
+{
+    qint64 total = 0;
+    foreach (WebView* view, m_views)
+        total += view->backingStoreMetrics()->tileMemoryBytes();
+    return total;
+}
+
+void TileMemoryBudget::enforce()
+{
+    if (!QWebSettings::globalSettings()->testAttribute(QWebSettings::TiledBackingStoreEnabled))
+        return;
+
+    qint64 remaining = s_tileMemoryBudgetBytes;
+    for (int i = 0; i < m_views.count(); ++i) {
+        WebView* view = m_views.at(i);
+        bool active = !i;
+        if (view->tileStoreTuner()->isInBackgroundMode() != !active) {
+            view->tileStoreTuner()->setBackgroundMode(!active);
+            if (!active)
+                updateHiddenTiles(view);
+        }
+        if (active) {
+            setTilesDropped(view, false);
+            remaining -= view->backingStoreMetrics()->tileMemoryBytes();
+            continue;
+        }
+        if (m_viewsWithoutTiles.contains(view))
+            continue;
+        qint64 bytes = view->backingStoreMetrics()->tileMemoryBytes();
+        if (bytes <= remaining)
+            remaining -= bytes;
+        else
+            setTilesDropped(view, true);
+    }
+
+    m_peakTileMemoryBytes = qMax(m_peakTileMemoryBytes, s_tileMemoryBudgetBytes - remaining);
+}
+
+void TileMemoryBudget::setTilesDropped(WebView* view, bool dropped)
+{
+    if (m_viewsWithoutTiles.contains(view) == dropped)
+        return;
+
+#if defined(ENABLE_TILE_MEMORY_BUDGET_DEBUG)
+    qDebug() << __FUNCTION__ << view->url() << dropped << view->backingStoreMetrics()->tileMemoryBytes();
+#endif
+
+    // a page specific setting, the frame deletes its backing store when
+    // it is turned off and creates a new one when it is turned back on
+    view->page()->settings()->setAttribute(QWebSettings::TiledBackingStoreEnabled, !dropped);
+    if (dropped) {
+        m_viewsWithoutTiles.insert(view);
+        m_tileDropCount++;
+    } else {
+        m_viewsWithoutTiles.remove(view);
+        // the new backing store starts with default settings
+        view->tileStoreTuner()->applySettings();
+    }
+    view->backingStoreMetrics()->reset();
+}
+
+void TileMemoryBudget::updateHiddenTiles(WebView* view)
+{
+    if (!view->isTiledBackingStoreFrozen())
+        return;
+    view->setTiledBackingStoreFrozen(false);
+    m_viewsUpdatingTiles.insert(view);
+    if (!m_refreezeTimer.isActive())
+        m_refreezeTimer.start(s_hiddenTileUpdateMS, this);
+}
+
+void TileMemoryBudget::writeReport(QTextStream& stream) const
+{
+    stream << "[tile memory]" << endl;
+    stream << "budget: " << s_tileMemoryBudgetBytes / 1024 << "kB"
+           << ", in use: " << totalTileMemoryBytes() / 1024 << "kB"
+           << ", peak: " << m_peakTileMemoryBytes / 1024 << "kB"
+           << ", background tabs purged: " << m_tileDropCount << endl;
+    for (int i = 0; i < m_views.count(); ++i) {
+        WebView* view = m_views.at(i);
+        stream << "tab " << i << " ";
+        if (!i)
+            stream << "(active) ";
+        else if (m_viewsWithoutTiles.contains(view))
+            stream << "(no tiles) ";
+        else
+            stream << "(visible area) ";
+        stream << view->url().host() << ": "
+               << view->backingStoreMetrics()->liveTileCount() << " tiles, "
+               << view->backingStoreMetrics()->tileMemoryBytes() / 1024 << "kB" << endl;
+    }
+}
+
+#endif
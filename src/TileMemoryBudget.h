@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef TileMemoryBudget_h
+#define TileMemoryBudget_h
+
+#if !USE_WEBKIT2
+#include <QBasicTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include "yberconfig.h"
+
+class QTextStream;
+class WebView;
+
+class TileMemoryBudget : public QObject
+{
+    Q_OBJECT
+public:
+    static TileMemoryBudget* instance();
+
+    void activate(WebView*);
+
+    qint64 totalTileMemoryBytes() const;
+    void writeReport(QTextStream&) const;
+
+protected:
+    void timerEvent(QTimerEvent*);
+
+private Q_SLOTS:
+    void viewDestroyed(QObject*);
+
+private:
+    TileMemoryBudget();
+    Q_DISABLE_COPY(TileMemoryBudget)
+
+    void enforce();
+    void setTilesDropped(WebView*, bool dropped);
+    void updateHiddenTiles(WebView*);
+
+    // most recently used first
+    QList<WebView*> m_views;
+    // destroyed() hands out a QObject that is no longer a WebView
+    QHash<QObject*, WebView*> m_viewsByObject;
+    QSet<WebView*> m_viewsWithoutTiles;
+    QSet<WebView*> m_viewsUpdatingTiles;
+    QBasicTimer m_enforceTimer;
+    QBasicTimer m_refreezeTimer;
+    qint64 m_peakTileMemoryBytes;
+    int m_tileDropCount;
+};
+#endif
+#endif
@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "TileStoreTuner.h"
+#include "Settings.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QTextStream>
+#include <QTimerEvent>
+
+#if !USE_WEBKIT2
+#include <qgraphicswebview.h>
+#endif
+
+//#define ENABLE_TILE_STORE_TUNER_DEBUG
+
+namespace {
+const int s_tuningIntervalMS = 2000;
+// a view needs to have been drawn this many times during the interval
+// for the sample to say anything about the tile settings
+const int s_minFramesPerDecision = 10;
+// tile size change throws away all tiles of the page, do it rarely
+const int s_minTileSizeChangeIntervalMS = 20000;
+const int s_maxDecisionLogLength = 100;
+const qint64 s_maxDecisionLogFileSize = 256 * 1024;
+
+const qreal s_highCheckerboardRate = .05;
+const qreal s_lowCheckerboardRate = .005;
+const qreal s_highTilePaintCostMS = 12;
+const qreal s_lowTilePaintCostMS = 4;
+const qint64 s_maxTileMemoryBytes = 16 * 1024 * 1024;
+
+// limits of the adjustable settings
+const int s_minTileSize = 128;
+const int s_maxTileSize = 512;
+const int s_minTileCreationDelayMS = 10;
+const int s_maxTileCreationDelayMS = 100;
+const int s_tileCreationDelayStepMS = 10;
+const qreal s_minCoverAreaMultiplier = 1.;
+const qreal s_maxCoverAreaMultiplier = 2.5;
+const qreal s_minKeepAreaMultiplier = 1.5;
+const qreal s_maxKeepAreaMultiplier = 3.5;
+const qreal s_areaMultiplierStep = .25;
+
+bool stepMultiplier(QSizeF& multiplier, qreal step, qreal min, qreal max)
+{
+    QSizeF stepped(qBound(min, multiplier.width() + step, max), qBound(min, multiplier.height() + step, max));
+    if (stepped == multiplier)
+        return false;
+    multiplier = stepped;
+    return true;
+}
+}
+
+TileStoreSettings::TileStoreSettings()
+    : tileSize(256, 256)
+    , tileCreationDelay(25)
+    , coverAreaMultiplier(1.5, 1.5)
+    , keepAreaMultiplier(2., 2.5)
+{
+}
+
+void TileStoreSettings::applyTo(QObject* page) const
+{
+    page->setProperty("_q_TiledBackingStoreTileSize", tileSize);
+    page->setProperty("_q_TiledBackingStoreTileCreationDelay", tileCreationDelay);
+    page->setProperty("_q_TiledBackingStoreCoverAreaMultiplier", coverAreaMultiplier);
+    page->setProperty("_q_TiledBackingStoreKeepAreaMultiplier", keepAreaMultiplier);
+}
+
+bool TileStoreSettings::operator==(const TileStoreSettings& other) const
+{
+    return tileSize == other.tileSize
+        && tileCreationDelay == other.tileCreationDelay
+        && coverAreaMultiplier == other.coverAreaMultiplier
+        && keepAreaMultiplier == other.keepAreaMultiplier;
+}
+
+QString TileStoreSettings::toString() const
+{
+    return QString("tile %1x%2 delay %3ms cover %4x%5 keep %6x%7")
+        .arg(tileSize.width()).arg(tileSize.height())
+        .arg(tileCreationDelay)
+        .arg(coverAreaMultiplier.width()).arg(coverAreaMultiplier.height())
+        .arg(keepAreaMultiplier.width()).arg(keepAreaMultiplier.height());
+}
+
+#if !USE_WEBKIT2
+
+/*! \class TileStoreTuner adjusts the tiled backing store settings of a
+  page to the content being viewed.
+
+  Every couple of seconds the frames drawn since the previous
+  evaluation are looked at and at most one setting is moved one step
+  within its limits: memory over budget shrinks the keep and cover
+  areas, checkerboarding makes tiles smaller when they are expensive to
+  paint or otherwise creates them sooner and over a larger area, and a
+  clean interval lets the settings relax back. Each decision is logged
+  to decisionLog() and Settings::tileStoreTuningLogFilePath().
+*/
+TileStoreTuner::TileStoreTuner(QGraphicsWebView* webView, BackingStoreMetrics* metrics, QObject* parent)
+    : QObject(parent)
+    , m_webView(webView)
+    , m_metrics(metrics)
+    , m_backgroundMode(false)
+{
+    setEnabled(Settings::instance()->tileStoreTuningEnabled());
+}
+
+TileStoreTuner::~TileStoreTuner()
+{
+}
+
+void TileStoreTuner::setEnabled(bool enabled)
+{
+    if (enabled && !m_tuningTimer.isActive())
+        m_tuningTimer.start(s_tuningIntervalMS, this);
+    else if (!enabled)
+        m_tuningTimer.stop();
+}
+
+/*!
+  A view in background mode is not tuned and keeps tiles for its
+  visible area only.
+*/
+void TileStoreTuner::setBackgroundMode(bool background)
+{
+    if (m_backgroundMode == background)
+        return;
+    m_backgroundMode = background;
+    setEnabled(!background && Settings::instance()->tileStoreTuningEnabled());
+    m_metrics->takeSample();
+    applySettings();
+}
+
+void TileStoreTuner::applySettings()
+{
+    if (!m_webView->page())
+        return;
+    TileStoreSettings settings = m_settings;
+    if (m_backgroundMode) {
+        settings.coverAreaMultiplier = QSizeF(1., 1.);
+        settings.keepAreaMultiplier = QSizeF(1., 1.);
+    }
+    bool tileSizeChanged = m_webView->page()->property("_q_TiledBackingStoreTileSize").toSize() != settings.tileSize;
+    settings.applyTo(m_webView->page());
+    // the backing store drops its tiles when the tile size changes
+    if (tileSizeChanged)
+        m_metrics->reset();
+}
+
+void TileStoreTuner::timerEvent(QTimerEvent* ev)
+{
+    if (ev->timerId() == m_tuningTimer.timerId()) {
+        evaluate();
+        return;
+    }
+    return QObject::timerEvent(ev);
+}
+
+bool TileStoreTuner::canChangeTileSize() const
+{
+    return m_lastTileSizeChange.isNull() || m_lastTileSizeChange.elapsed() > s_minTileSizeChangeIntervalMS;
+}
+
+void TileStoreTuner::evaluate()
+{
+    BackingStoreMetrics::Sample sample = m_metrics->takeSample();
+    if (sample.frames < s_minFramesPerDecision)
+        return;
+
+    const TileStoreSettings defaults;
+    TileStoreSettings next = m_settings;
+    QString reason;
+
+    if (sample.tileMemoryBytes > s_maxTileMemoryBytes) {
+        if (stepMultiplier(next.keepAreaMultiplier, -s_areaMultiplierStep, s_minKeepAreaMultiplier, s_maxKeepAreaMultiplier)) {
+            next.coverAreaMultiplier = next.coverAreaMultiplier.boundedTo(next.keepAreaMultiplier);
+            reason = "tile memory over budget, shrink keep area";
+        } else if (stepMultiplier(next.coverAreaMultiplier, -s_areaMultiplierStep, s_minCoverAreaMultiplier, s_maxCoverAreaMultiplier)) {
+            reason = "tile memory over budget, shrink cover area";
+        } else
+            reason = "tile memory over budget, areas at lower limits";
+    } else if (sample.checkerboardRate > s_highCheckerboardRate) {
+        if (sample.averagePaintCostMS > s_highTilePaintCostMS && next.tileSize.width() > s_minTileSize && canChangeTileSize()) {
+            next.tileSize = (next.tileSize / 2).expandedTo(QSize(s_minTileSize, s_minTileSize));
+            reason = "checkerboarding with expensive tiles, use smaller tiles";
+        } else if (next.tileCreationDelay > s_minTileCreationDelayMS) {
+            next.tileCreationDelay = qMax(s_minTileCreationDelayMS, next.tileCreationDelay - s_tileCreationDelayStepMS);
+            reason = "checkerboarding, create tiles sooner";
+        } else if (sample.tileMemoryBytes < s_maxTileMemoryBytes / 2
+                   && stepMultiplier(next.coverAreaMultiplier, s_areaMultiplierStep, s_minCoverAreaMultiplier, s_maxCoverAreaMultiplier)) {
+            next.keepAreaMultiplier = next.keepAreaMultiplier.expandedTo(next.coverAreaMultiplier);
+            reason = "checkerboarding, grow cover area";
+        } else
+            reason = "checkerboarding, settings at limits";
+    } else if (sample.checkerboardRate < s_lowCheckerboardRate) {
+        if (next.tileCreationDelay < s_maxTileCreationDelayMS) {
+            next.tileCreationDelay = qMin(s_maxTileCreationDelayMS, next.tileCreationDelay + s_tileCreationDelayStepMS);
+            reason = "no checkerboarding, create tiles lazier";
+        } else if (next.coverAreaMultiplier.width() > defaults.coverAreaMultiplier.width()
+                   && stepMultiplier(next.coverAreaMultiplier, -s_areaMultiplierStep, defaults.coverAreaMultiplier.width(), s_maxCoverAreaMultiplier)) {
+            reason = "no checkerboarding, shrink cover area back";
+        } else if (sample.paintCostSamples && sample.averagePaintCostMS < s_lowTilePaintCostMS
+                   && sample.tileMemoryBytes < s_maxTileMemoryBytes / 4
+                   && next.tileSize.width() < s_maxTileSize && canChangeTileSize()) {
+            next.tileSize = (next.tileSize * 2).boundedTo(QSize(s_maxTileSize, s_maxTileSize));
+            reason = "no checkerboarding with cheap tiles, use larger tiles";
+        } else
+            reason = "no checkerboarding, keep settings";
+    } else
+        reason = "within targets, keep settings";
+
+    logDecision(sample, next, reason);
+
+    if (next == m_settings)
+        return;
+    if (next.tileSize != m_settings.tileSize)
+        m_lastTileSizeChange.start();
+    m_settings = next;
+    applySettings();
+}
+
+void TileStoreTuner::logDecision(const BackingStoreMetrics::Sample& sample, const TileStoreSettings& next, const QString& reason)
+{
+    QString entry = QString("%1 %2 frames %3 checkerboard %4% paint cost %5ms tiles %6 (%7kB): %8")
+        .arg(QDateTime::currentDateTime().toString(Qt::ISODate))
+        .arg(m_webView->url().host())
+        .arg(sample.frames)
+        .arg(sample.checkerboardRate * 100, 0, 'f', 2)
+        .arg(sample.averagePaintCostMS, 0, 'f', 1)
+        .arg(sample.liveTiles)
+        .arg(sample.tileMemoryBytes / 1024)
+        .arg(reason);
+    if (next != m_settings)
+        entry += QString(" [%1 -> %2]").arg(m_settings.toString()).arg(next.toString());
+
+#if defined(ENABLE_TILE_STORE_TUNER_DEBUG)
+    qDebug() << __FUNCTION__ << entry;
+#endif
+
+    m_decisionLog.append(entry);
+    if (m_decisionLog.count() > s_maxDecisionLogLength)
+        m_decisionLog.removeFirst();
+
+    QFile logFile(Settings::instance()->tileStoreTuningLogFilePath());
+    QIODevice::OpenMode mode = QIODevice::WriteOnly | QIODevice::Text;
+    mode |= logFile.size() > s_maxDecisionLogFileSize ? QIODevice::Truncate : QIODevice::Append;
+    if (!logFile.open(mode))
+        return;
+    QTextStream stream(&logFile);
+    stream << entry << endl;
+}
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef TileStoreTuner_h
+#define TileStoreTuner_h
+
+#include <QObject>
+#include <QSize>
+#include <QSizeF>
+#include "yberconfig.h"
+
+struct TileStoreSettings {
+    TileStoreSettings();
+    void applyTo(QObject* page) const;
+    bool operator==(const TileStoreSettings& other) const;
+    bool operator!=(const TileStoreSettings& other) const { return !(*this == other); }
+    QString toString() const;
+
+    QSize tileSize;
+    int tileCreationDelay;
+    QSizeF coverAreaMultiplier;
+    QSizeF keepAreaMultiplier;
+};
+
+#if !USE_WEBKIT2
+#include <QBasicTimer>
+#include <QStringList>
+#include <QTime>
+#include "BackingStoreMetrics.h"
+
+class QGraphicsWebView;
+
+class TileStoreTuner : public QObject
+{
+    Q_OBJECT
+public:
+    TileStoreTuner(QGraphicsWebView*, BackingStoreMetrics*, QObject* parent = 0);
+    ~TileStoreTuner();
+
+    void setEnabled(bool);
+    bool isEnabled() const { return m_tuningTimer.isActive(); }
+
+    void setBackgroundMode(bool);
+    bool isInBackgroundMode() const { return m_backgroundMode; }
+
+    const TileStoreSettings& settings() const { return m_settings; }
+    void applySettings();
+
+    const QStringList& decisionLog() const { return m_decisionLog; }
+
+protected:
+    void timerEvent(QTimerEvent*);
+
+private:
+    Q_DISABLE_COPY(TileStoreTuner)
+
+    void evaluate();
+    bool canChangeTileSize() const;
+    void logDecision(const BackingStoreMetrics::Sample&, const TileStoreSettings& next, const QString& reason);
+
+    QGraphicsWebView* m_webView;
+    BackingStoreMetrics* m_metrics;
+    TileStoreSettings m_settings;
+    bool m_backgroundMode;
+    QBasicTimer m_tuningTimer;
+    QTime m_lastTileSizeChange;
+    QStringList m_decisionLog;
+};
+#endif
+#endif
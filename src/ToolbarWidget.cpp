@@ -23,6 +23,9 @@
 #include "Settings.h"
 #include "HistoryStore.h"
 #include "KeypadWidget.h"
+#include "Helpers.h"
+#include "Preconnector.h"
+#include "Prefetcher.h"
 
 #include <QUrl>
 #include <QImage>
@@ -133,6 +136,8 @@ void ToolbarWidget::textEdited(const QString& newText)
         // todo: make it async
         QString match = HistoryStore::instance()->match(text);
         if (!match.isEmpty()) {
+            Preconnector::instance()->warmUp(urlFromUserInput(match));
+            Prefetcher::instance()->prefetchAfterTypingPause(urlFromUserInput(match));
             m_urlEdit->setText(match);
             m_urlEdit->setCursorPosition(text.size());
             m_urlEdit->setSelection(text.size(), match.size() - text.size());
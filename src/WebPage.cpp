@@ -30,12 +30,8 @@ WebPage::WebPage(QObject* parent, BrowsingView* ownerView)
     , m_ownerView(ownerView)
 {
 #if !USE_WEBKIT2
-    CookieJar* jar = YberApplication::instance()->cookieJar();
-    // setCookieJar changes the parent of the passed jar ;(
-    // So we need to preserve it
-    QObject* oldParent = jar->parent();
-    networkAccessManager()->setCookieJar(jar);
-    jar->setParent(oldParent);
+    // all pages share one connection pool, cache and cookie jar
+    setNetworkAccessManager(YberApplication::instance()->networkAccessManager());
 #endif
 }
 
@@ -19,8 +19,24 @@
  */
 
 #include "WebView.h"
+#include "TileStoreTuner.h"
 #if USE_WEBKIT2
 #include <WebKit2/WKFrame.h>
+#else
+#include "BackingStoreMetrics.h"
+#include "BackingStoreVisualizerWidget.h"
+#include "PageGeometryCache.h"
+#include "PageThrottle.h"
+#include "Settings.h"
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+namespace {
+// longest time the pre-zoom rendering may stand in for missing tiles
+const int s_maxScaleChangeBackdropMS = 500;
+}
 #endif
 
 #if USE_WEBKIT2
@@ -41,8 +57,41 @@ WebView::WebView(WKPageNamespaceRef namespaceRef, QGraphicsItem* parent)
 WebView::WebView(QGraphicsItem* parent)
     : QGraphicsWebView(parent)
     , m_fpsTicks(0)
+    , m_backingStoreMetrics(new BackingStoreMetrics(this, this))
+    , m_tileStoreTuner(new TileStoreTuner(this, m_backingStoreMetrics, this))
+    , m_backingStoreVisualizer(0)
+    , m_pageGeometryCache(new PageGeometryCache(this, this))
+    , m_pageThrottle(new PageThrottle(this, this))
+{
+    applyPageSettings();
+    m_pageGeometryCache->attachToPage();
+    m_pageThrottle->attachToPage();
+    if (Settings::instance()->tileVisualizationEnabled())
+        m_backingStoreVisualizer = new BackingStoreVisualizerWidget(this, m_backingStoreMetrics);
+}
+
+/*!
+  Replaces the page and moves the metrics, the geometry cache, the
+  throttle and the visualizer over to it.
+
+  QGraphicsWebView::setPage() is not virtual and there is no signal for a
+  page change, so the page must always be set through a WebView pointer;
+  a call through QGraphicsWebView would leave the helpers on the old page.
+*/
+void WebView::setPage(QWebPage* page)
 {
+    m_backingStoreMetrics->detachFromPage();
+    m_pageGeometryCache->detachFromPage();
+    m_pageThrottle->detachFromPage();
+    if (m_backingStoreVisualizer)
+        m_backingStoreVisualizer->detachFromPage();
+    QGraphicsWebView::setPage(page);
+    // tile settings are page properties, apply them to the new page
     applyPageSettings();
+    m_pageGeometryCache->attachToPage();
+    m_pageThrottle->attachToPage();
+    if (m_backingStoreVisualizer)
+        m_backingStoreVisualizer->attachToPage();
 }
 #endif
 
@@ -52,14 +101,83 @@ void WebView::paint(QPainter* p, const QStyleOptionGraphicsItem* option, QWidget
 #if USE_WEBKIT2
     QGraphicsWKView::paint(p, option, w);
 #else
+    // snapshots are painted without a widget, only count frames on screen
+    if (w && !m_scaleChangeBackdrop.isNull() && paintScaleChangeBackdrop(p, option->exposedRect))
+        return;
+    if (w)
+        m_backingStoreMetrics->frameRendered(option->exposedRect);
     QGraphicsWebView::paint(p, option, w);
 #endif
 }
 
+#if !USE_WEBKIT2
+/*!
+  Returns the part of the view that is on screen, in item coordinates.
+*/
+QRectF WebView::visibleRect() const
+{
+    if (!scene() || scene()->views().isEmpty())
+        return QRectF();
+    QGraphicsView* view = scene()->views().first();
+    QRectF visible = mapFromScene(view->mapToScene(view->viewport()->rect())).boundingRect();
+    // the viewport item clips its children
+    if (parentItem())
+        visible &= mapFromParent(parentItem()->boundingRect()).boundingRect();
+    return visible & boundingRect();
+}
+
+/*!
+  Renders the visible area from the current tiles before the contents
+  scale is changed. The backing store drops all its tiles on a scale
+  change, so until the visible tiles of the new scale have been painted
+  this rendering is drawn instead of checkerboard.
+*/
+void WebView::prepareScaleChange()
+{
+    m_scaleChangeBackdrop = QPixmap();
+    QRectF visible = visibleRect();
+    if (visible.isEmpty())
+        return;
+
+    qreal currentScale = scale() * transform().m11();
+    QPixmap backdrop((visible.size() * currentScale).toSize());
+    if (backdrop.isNull())
+        return;
+
+    QPainter painter(&backdrop);
+    painter.scale(currentScale, currentScale);
+    painter.translate(-visible.topLeft());
+    QStyleOptionGraphicsItem option;
+    option.exposedRect = visible;
+    QGraphicsWebView::paint(&painter, &option, 0);
+    painter.end();
+
+    m_scaleChangeBackdrop = backdrop;
+    m_scaleChangeBackdropRect = visible;
+    m_scaleChangeTime.start();
+}
+
+bool WebView::paintScaleChangeBackdrop(QPainter* p, const QRectF& exposedRect)
+{
+    // the backdrop only covers the area it was rendered from, and it
+    // gives way as soon as the tiles of the new scale cover that area
+    if (m_scaleChangeTime.elapsed() > s_maxScaleChangeBackdropMS
+        || !m_scaleChangeBackdropRect.adjusted(-1, -1, 1, 1).contains(exposedRect)
+        || m_backingStoreMetrics->isAreaPainted(m_scaleChangeBackdropRect)) {
+        m_scaleChangeBackdrop = QPixmap();
+        return false;
+    }
+    p->drawPixmap(m_scaleChangeBackdropRect, m_scaleChangeBackdrop, m_scaleChangeBackdrop.rect());
+    return true;
+}
+#endif
+
 void WebView::applyPageSettings()
 {
-    page()->setProperty("_q_TiledBackingStoreTileSize", QSize(256, 256));
-    page()->setProperty("_q_TiledBackingStoreTileCreationDelay", 25);
-    page()->setProperty("_q_TiledBackingStoreCoverAreaMultiplier", QSizeF(1.5, 1.5));
-    page()->setProperty("_q_TiledBackingStoreKeepAreaMultiplier", QSizeF(2., 2.5));
+#if USE_WEBKIT2
+    TileStoreSettings().applyTo(page());
+#else
+    m_tileStoreTuner->applySettings();
+    m_backingStoreMetrics->attachToPage();
+#endif
 }
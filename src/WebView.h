@@ -27,10 +27,20 @@
 #include <WebKit2/qgraphicswkview.h>
 #else
 #include <qgraphicswebview.h>
+#include <QPixmap>
+#include <QTime>
 #endif
 #include "yberconfig.h"
 #include "PannableViewport.h"
 
+#if !USE_WEBKIT2
+class BackingStoreMetrics;
+class BackingStoreVisualizerWidget;
+class PageGeometryCache;
+class PageThrottle;
+class TileStoreTuner;
+#endif
+
 class WebView : public
 #if USE_WEBKIT2
     QGraphicsWKView
@@ -48,12 +58,38 @@ public:
     void paint(QPainter* p, const QStyleOptionGraphicsItem* i, QWidget* w= 0);
     unsigned int fpsTicks() const { return m_fpsTicks; }
 
+#if !USE_WEBKIT2
+    // hides QGraphicsWebView::setPage(), always call it through WebView
+    void setPage(QWebPage*);
+    BackingStoreMetrics* backingStoreMetrics() const { return m_backingStoreMetrics; }
+    TileStoreTuner* tileStoreTuner() const { return m_tileStoreTuner; }
+    BackingStoreVisualizerWidget* backingStoreVisualizer() const { return m_backingStoreVisualizer; }
+    PageGeometryCache* pageGeometryCache() const { return m_pageGeometryCache; }
+    PageThrottle* pageThrottle() const { return m_pageThrottle; }
+
+    void prepareScaleChange();
+#endif
+
 private:
     Q_DISABLE_COPY(WebView)
     void applyPageSettings();
+#if !USE_WEBKIT2
+    QRectF visibleRect() const;
+    bool paintScaleChangeBackdrop(QPainter*, const QRectF& exposedRect);
+#endif
 
 private:
     unsigned int m_fpsTicks;
+#if !USE_WEBKIT2
+    BackingStoreMetrics* m_backingStoreMetrics;
+    TileStoreTuner* m_tileStoreTuner;
+    BackingStoreVisualizerWidget* m_backingStoreVisualizer;
+    PageGeometryCache* m_pageGeometryCache;
+    PageThrottle* m_pageThrottle;
+    QPixmap m_scaleChangeBackdrop;
+    QRectF m_scaleChangeBackdropRect;
+    QTime m_scaleChangeTime;
+#endif
 };
 
 #endif
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "WebViewPool.h"
+
+#if !USE_WEBKIT2
+
+#include "FrameClock.h"
+#include "WebPage.h"
+#include "WebView.h"
+
+#include <QTextStream>
+#include <QTimerEvent>
+
+namespace {
+const int s_poolSize = 2;
+// how long the application has to be idle before a view is constructed
+const int s_refillDelayMS = 1000;
+
+struct NewTabTotals {
+    int opened;
+    int pooled;
+    int constructed;
+    int totalLatencyMS;
+    int maxLatencyMS;
+};
+NewTabTotals s_newTabs = { 0, 0, 0, 0, 0 };
+}
+
+/*! \class WebViewPool keeps WebViews constructed ahead of time.
+
+  Building a view and its page, hooking up the network stack and
+  applying the page settings is visible latency when a tab is opened.
+  The pool hands out views made earlier and builds replacements one at
+  a time when nothing is animating.
+*/
+WebViewPool::WebViewPool(BrowsingView* ownerView, QObject* parent)
+    : QObject(parent)
+    , m_ownerView(ownerView)
+{
+    // let the startup finish before filling the pool
+    scheduleRefill();
+}
+
+WebViewPool::~WebViewPool()
+{
+    qDeleteAll(m_views);
+}
+
+WebView* WebViewPool::take()
+{
+    WebView* webView;
+    if (m_views.isEmpty()) {
+        s_newTabs.constructed++;
+        webView = createWebView();
+    } else {
+        s_newTabs.pooled++;
+        webView = m_views.takeFirst();
+    }
+    scheduleRefill();
+    return webView;
+}
+
+WebView* WebViewPool::createWebView()
+{
+    WebView* webView = new WebView();
+    webView->setPage(new WebPage(webView, m_ownerView));
+    return webView;
+}
+
+void WebViewPool::scheduleRefill()
+{
+    if (m_views.size() < s_poolSize)
+        m_refillTimer.start(s_refillDelayMS, this);
+}
+
+void WebViewPool::timerEvent(QTimerEvent* ev)
+{
+    if (ev->timerId() != m_refillTimer.timerId()) {
+        QObject::timerEvent(ev);
+        return;
+    }
+    m_refillTimer.stop();
+
+    // constructing a view takes longer than a frame, wait for the animation to end
+    if (!FrameClock::instance()->isTicking())
+        m_views.append(createWebView());
+    scheduleRefill();
+}
+
+void WebViewPool::newTabOpened(int latencyMS)
+{
+    s_newTabs.opened++;
+    s_newTabs.totalLatencyMS += latencyMS;
+    s_newTabs.maxLatencyMS = qMax(s_newTabs.maxLatencyMS, latencyMS);
+}
+
+void WebViewPool::writeSessionReport(QTextStream& stream)
+{
+    stream << "[new tabs]" << endl;
+    stream << "views from pool: " << s_newTabs.pooled << endl;
+    stream << "views constructed on demand: " << s_newTabs.constructed << endl;
+    stream << "tabs opened: " << s_newTabs.opened << endl;
+    if (s_newTabs.opened) {
+        stream << "mean latency: " << s_newTabs.totalLatencyMS / s_newTabs.opened << "ms" << endl;
+        stream << "max latency: " << s_newTabs.maxLatencyMS << "ms" << endl;
+    }
+}
+
+#endif
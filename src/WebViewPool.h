@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2010 Nokia Corporation and/or its subsidiary(-ies)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this program; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef WebViewPool_h
+#define WebViewPool_h
+
+#if !USE_WEBKIT2
+#include <QBasicTimer>
+#include <QList>
+#include <QObject>
+#include "yberconfig.h"
+
+class BrowsingView;
+class QTextStream;
+class WebView;
+
+class WebViewPool : public QObject
+{
+    Q_OBJECT
+public:
+    WebViewPool(BrowsingView* ownerView, QObject* parent = 0);
+    ~WebViewPool();
+
+    WebView* take();
+
+    static void newTabOpened(int latencyMS);
+    static void writeSessionReport(QTextStream&);
+
+protected:
+    void timerEvent(QTimerEvent*);
+
+private:
+    Q_DISABLE_COPY(WebViewPool)
+
+    WebView* createWebView();
+    void scheduleRefill();
+
+    BrowsingView* m_ownerView;
+    QList<WebView*> m_views;
+    QBasicTimer m_refillTimer;
+};
+#endif
+#endif
@@ -22,20 +22,29 @@
 #include <QApplication>
 #include "EventHelpers.h"
 #include "LinkSelectionItem.h"
+#include "PageGeometryCache.h"
+#include "Preconnector.h"
+#include "Prefetcher.h"
 #include "WebView.h"
 #include "WebViewport.h"
 #include "WebViewportItem.h"
+#include "Settings.h"
+#if !USE_WEBKIT2
+#include "BackingStoreMetrics.h"
+#endif
 #include "qwebframe.h"
 #include "qgraphicswebview.h"
 #include "qwebelement.h"
+#include "qwebkitversion.h"
 
 #include <QGraphicsScene>
 #include <QGraphicsLinearLayout>
-#include <QMetaMethod>
+#include <QtGlobal>
 
  #include <QGraphicsSceneResizeEvent>
 
 //#define ENABLE_LINK_SELECTION_DEBUG
+//#define ENABLE_PAN_UPDATE_DEBUG
 
 namespace {
 const float s_zoomScaleWheelStep = .2;
@@ -44,6 +53,13 @@ const int s_minSearchRectSize = 8;
 const int s_maxSearchRectSize = 25;
 const int backingStoreUpdateEnableDelay = 700;
 const int s_geomAnimDuration = 300;
+// pans slower than this (px/s) keep painting tiles
+const qreal s_maxProgressiveUpdatePanVelocity = 500;
+const int s_maxTilePaintsPerPanFrame = 2;
+const int s_maxTilePaintsPerZoomAnimFrame = 2;
+const qreal s_panVelocitySmoothing = .3;
+// zoom scale a pinch may zoom in to, unless the page already is closer
+const qreal s_maxPinchZoomScale = 4.;
 
 }
 
@@ -66,13 +82,18 @@ WebViewport::WebViewport(QGraphicsItem* parent)
     , m_selfSentEvent(0)
     , m_linkSelectionItem(0)
     , m_delayedMouseReleaseEvent(0)
+    , m_pinchActive(false)
+    , m_pinchStartDistance(0)
 #if defined(ENABLE_LINK_SELECTION_VISUAL_DEBUG)
     , m_searchRectItem(0)
     , m_clickablePointItem(0)
 #endif
     , m_wasPanning(false)
+    , m_panVelocity(s_maxProgressiveUpdatePanVelocity)
 {
     setFiltersChildEvents(true);
+    // touches the page does not take are pinches for the viewport
+    setAcceptTouchEvents(true);
     // AutoRange is set to false, because MPannableViewport observes
     // sizehints, not the size of the contained object
     // setting sizehints for every resize doesn't seem to work
@@ -81,15 +102,9 @@ WebViewport::WebViewport(QGraphicsItem* parent)
     setPanDirection(Qt::Horizontal | Qt::Vertical);
     setWidget(m_viewportWidget);
 
-    m_geomAnim.addAnimation(&m_posAnim);
-    m_geomAnim.addAnimation(&m_sizeAnim);
-
-    m_posAnim.setTargetObject(this);
-    m_posAnim.setDuration(s_geomAnimDuration);
-    m_posAnim.setPropertyName("position");
-    m_sizeAnim.setTargetObject(m_viewportWidget);
-    m_sizeAnim.setDuration(s_geomAnimDuration);
-    m_sizeAnim.setPropertyName("size");
+    m_geomAnim.setTargetObject(this);
+    m_geomAnim.setDuration(s_geomAnimDuration);
+    m_geomAnim.setPropertyName("pannedWidgetAnimGeometry");
 
     connect(&m_geomAnim, SIGNAL(stateChanged(QAbstractAnimation::State,QAbstractAnimation::State)), this, SLOT(geomAnimStateChanged(QAbstractAnimation::State,QAbstractAnimation::State)));
 
@@ -97,7 +112,7 @@ WebViewport::WebViewport(QGraphicsItem* parent)
     connect(m_viewportWidget, SIGNAL(zoomRectForPointReceived(const QPointF&, const QRectF&)), SLOT(zoomRectForPointReceived(const QPointF&, const QRectF&)));
     m_backingStoreUpdateEnableTimer.setSingleShot(true);
     connect(&m_backingStoreUpdateEnableTimer, SIGNAL(timeout()), this, SLOT(enableBackingStoreUpdates()));
-    connect(this, SIGNAL(positionChanged(const QRectF&)), this, SLOT(webPanningStarted()));
+    connect(this, SIGNAL(positionChanged(const QRectF&)), this, SLOT(webPanningStarted(const QRectF&)));
     connect(this, SIGNAL(panningStopped()), this, SLOT(webPanningStopped()));
 }
 
@@ -112,6 +127,26 @@ WebViewport::~WebViewport()
 #endif
 }
 
+bool WebViewport::sceneEvent(QEvent* e)
+{
+    switch (e->type()) {
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+        pinchTouchEvent(static_cast<QTouchEvent*>(e));
+        e->accept();
+        return true;
+    case QEvent::GraphicsSceneMouseMove:
+        // the first finger of a pinch does not pan
+        if (m_pinchActive)
+            return true;
+        break;
+    default:
+        break;
+    }
+    return PannableViewport::sceneEvent(e);
+}
+
 bool WebViewport::sceneEventFilter(QGraphicsItem *i, QEvent *e)
 {
     // avoid filtering events that are self-sent
@@ -119,6 +154,9 @@ bool WebViewport::sceneEventFilter(QGraphicsItem *i, QEvent *e)
         return false;
     }
 
+    if (m_pinchActive && e->type() == QEvent::GraphicsSceneMouseMove)
+        return true;
+
     /* Apply super class event filter. This will capture mouse
     move for panning.  it will return true when applies panning
     but false until pan events are recognized
@@ -161,6 +199,15 @@ bool WebViewport::sceneEventFilter(QGraphicsItem *i, QEvent *e)
         doFilter = true;
         break;
 
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::TouchEnd:
+        // single touches belong to the page, pinches to the viewport
+        doFilter = pinchTouchEvent(static_cast<QTouchEvent*>(e));
+        if (doFilter)
+            e->accept();
+        break;
+
 #if defined(Q_WS_MAEMO_5)
     case QEvent::KeyPress:
         doFilter = processMaemo5ZoomKeys(static_cast<QKeyEvent*>(e));
@@ -216,6 +263,7 @@ void WebViewport::mousePressEventFromChild(QGraphicsSceneMouseEvent* event, bool
     {
         m_wasPanning = false;
         emit toolbarVisibleHint(true);
+        warmUpLinkAt(event->scenePos());
         return;
     }
 
@@ -229,39 +277,17 @@ void WebViewport::mousePressEventFromChild(QGraphicsSceneMouseEvent* event, bool
     m_selfSentEvent = 0;
 }
 
-QWebFrame* findFrame(const QPoint& pos, QWebFrame* frame)
-{
-    if (!frame)
-        return 0;
-    QList<QWebFrame*> children = frame->childFrames();
-    for (int i = 0; i < children.size(); ++i) {
-        if (findFrame(pos, children.at(i)))
-            return children.at(i);
-    }
-
-    if (frame->geometry().contains(pos))
-        return frame;
-    return 0;
-}
-
 void WebViewport::adjustClickPosition(QPointF& pos)
 {
 #if USE_WEBKIT2
     Q_UNUSED(pos);
 #else
-    QPointF localPos = m_viewportWidget->webView()->mapFromScene(pos);
+    WebView* webView = m_viewportWidget->webView();
+    QPointF localPos = webView->mapFromScene(pos);
 #if defined(ENABLE_LINK_SELECTION_DEBUG)
     qDebug() << __FUNCTION__ << " click pos:" << localPos << " scene pos:" << pos;
 #endif
-	QPoint pp(localPos.x(), localPos.y());
-    QWebFrame* qframe = findFrame(pp, m_viewportWidget->webView()->page()->mainFrame());
-    if (!qframe)
-        return;
-
-    static int methodOffset = qframe->metaObject()->indexOfMethod("findClickableNode(QRect,QPoint&)");
-    if (methodOffset < 0)
-        return;
-    static QMetaMethod findClickableNodeMethod = qframe->metaObject()->method(methodOffset);
+    QPoint pp(localPos.x(), localPos.y());
 
     QPoint resultPoint;
     // zoom dependent search rect size
@@ -270,26 +296,17 @@ void WebViewport::adjustClickPosition(QPointF& pos)
     QRect searchRect(pp.x() - searchDist, pp.y() - 2*searchDist, 2*searchDist, 4*searchDist);
 
 #if defined(ENABLE_LINK_SELECTION_DEBUG)
-    qDebug() << "clicked frame found:"<< qframe << " zoomscale:" << m_viewportWidget->zoomScale() << " search rect:" << searchRect;
+    qDebug() << "zoomscale:" << m_viewportWidget->zoomScale() << " search rect:" << searchRect;
 #endif
 
 #if defined(ENABLE_LINK_SELECTION_VISUAL_DEBUG)
     delete m_searchRectItem;
-    m_searchRectItem = new QGraphicsRectItem(QRectF(m_viewportWidget->webView()->mapToScene(searchRect).boundingRect()), this);
+    m_searchRectItem = new QGraphicsRectItem(QRectF(webView->mapToScene(searchRect).boundingRect()), this);
     delete m_clickablePointItem; m_clickablePointItem = 0;
 #endif
 
-    bool found;
-    findClickableNodeMethod.invoke(qframe, Q_RETURN_ARG(bool, found), Q_ARG(QRect, searchRect), Q_RETURN_ARG(QPoint, resultPoint));
-    if (found) {
-        pos = m_viewportWidget->webView()->mapToScene(resultPoint);
-#if defined(ENABLE_LINK_SELECTION_VISUAL_DEBUG)
-        m_clickablePointItem = new QGraphicsEllipseItem(m_viewportWidget->webView()->mapToScene(QRect(resultPoint.x() - 3, resultPoint.y() - 3, 6, 6)).boundingRect(), this);
-#endif
-#if defined(ENABLE_LINK_SELECTION_DEBUG)
-        qDebug() << "clickable node found at:" << resultPoint;
-#endif
-    } else {
+    bool found = webView->pageGeometryCache()->findClickablePoint(searchRect, pp, resultPoint);
+    if (!found) {
 #if defined(ENABLE_LINK_SELECTION_DEBUG)
         qDebug() << "clickable node NOT found, see if we need to go closer to the edge";
 #endif
@@ -303,30 +320,89 @@ void WebViewport::adjustClickPosition(QPointF& pos)
 #if defined(ENABLE_LINK_SELECTION_DEBUG)
         qDebug() << "search again:" << searchRect;
 #endif
-        // search again
-        qframe = findFrame(searchRect.center(), m_viewportWidget->webView()->page()->mainFrame());
-        if (!qframe)
-            return;
-        findClickableNodeMethod.invoke(qframe, Q_RETURN_ARG(bool, found), Q_ARG(QRect, searchRect), Q_RETURN_ARG(QPoint, resultPoint));
-        if (found) {
-            pos = m_viewportWidget->webView()->mapToScene(resultPoint);
+        found = webView->pageGeometryCache()->findClickablePoint(searchRect, pp, resultPoint);
+    }
+
+    if (found) {
+        pos = webView->mapToScene(resultPoint);
 #if defined(ENABLE_LINK_SELECTION_VISUAL_DEBUG)
-        m_clickablePointItem = new QGraphicsEllipseItem(m_viewportWidget->webView()->mapToScene(QRect(resultPoint.x() - 3, resultPoint.y() - 3, 6, 6)).boundingRect(), this);
+        m_clickablePointItem = new QGraphicsEllipseItem(webView->mapToScene(QRect(resultPoint.x() - 3, resultPoint.y() - 3, 6, 6)).boundingRect(), this);
 #endif
 #if defined(ENABLE_LINK_SELECTION_DEBUG)
-            qDebug() << "clickable node found at :" << resultPoint;
+        qDebug() << "clickable node found at:" << resultPoint;
 #endif
-        }
     }
 #endif
 }
 
+/*!
+  Starts looking up and connecting to the host of the link under a press,
+  and loading the link into the cache, while the press is decided. Only
+  the index is asked, which costs a grid lookup and no call into WebKit,
+  as most presses start a pan. A press that turns into a pan drops both
+  again.
+*/
+void WebViewport::warmUpLinkAt(const QPointF& scenePos)
+{
+#if USE_WEBKIT2
+    Q_UNUSED(scenePos);
+#else
+    dropLinkWarmUp();
+    WebView* webView = m_viewportWidget->webView();
+    PageGeometryCache::Element element;
+    if (!webView->pageGeometryCache()->indexedElementAt(webView->mapFromScene(scenePos).toPoint(), element) || !element.isLink)
+        return;
+    m_warmedLinkUrl = element.url;
+    Preconnector::instance()->warmUp(m_warmedLinkUrl);
+    if (m_linkPrefetchUrl != element.url) {
+        dropLinkPrefetch();
+        m_linkPrefetchUrl = element.url;
+        Prefetcher::instance()->prefetch(m_linkPrefetchUrl);
+    }
+#endif
+}
+
+void WebViewport::dropLinkWarmUp()
+{
+    if (m_warmedLinkUrl.isEmpty())
+        return;
+    Preconnector::instance()->cancel(m_warmedLinkUrl);
+    m_warmedLinkUrl = QUrl();
+}
+
+/*!
+  Classifies a tap at \a scenePos when it is released. Returns false when
+  the tap cannot be the first half of a double tap zoom, so that it can
+  be dispatched without waiting for a second tap: on pages that do not
+  allow zooming, and on links and form controls.
+*/
+bool WebViewport::isDoubleTapPossible(const QPointF& scenePos)
+{
+    if (!Settings::instance()->fastTapEnabled())
+        return true;
+#if USE_WEBKIT2
+    Q_UNUSED(scenePos);
+    return true;
+#else
+    WebView* webView = m_viewportWidget->webView();
+#if QTWEBKIT_VERSION >= QTWEBKIT_VERSION_CHECK(2, 1, 0)
+    QWebPage::ViewportAttributes viewport = webView->page()->viewportAttributesForSize(size().toSize());
+    if (viewport.isValid() && (!viewport.isUserScalable() || viewport.minimumScaleFactor() == viewport.maximumScaleFactor()))
+        return false;
+#endif
+    // click handlers also sit on page wide wrappers, which must not turn off double tap zoom
+    PageGeometryCache::Element element;
+    return !webView->pageGeometryCache()->clickableElementAt(webView->mapFromScene(scenePos).toPoint(), element) || !element.isControl;
+#endif
+}
+
 void WebViewport::mouseReleaseEventFromChild(QGraphicsSceneMouseEvent * event)
 {
     QTimer::singleShot(2000, this, SLOT(hintHideToolbar()));
 
     delete m_linkSelectionItem;
     m_linkSelectionItem = 0;
+    // a click still waiting from an earlier tap is superseded, its prefetch is decided below
     delete m_delayedMouseReleaseEvent;
     m_delayedMouseReleaseEvent = 0;
 
@@ -335,12 +411,20 @@ void WebViewport::mouseReleaseEventFromChild(QGraphicsSceneMouseEvent * event)
     QPointF p = event->pos();
 
 #if !USE_WEBKIT2
-    QWebHitTestResult result = m_viewportWidget->webView()->page()->mainFrame()->hitTestContent(QPoint(p.x(), p.y()));
+    PageGeometryCache::Element element;
+    bool isLink = m_viewportWidget->webView()->pageGeometryCache()->clickableElementAt(QPoint(p.x(), p.y()), element) && element.isLink;
+
+    // a tap on the pressed link keeps its warm up and prefetch for the click
+    if (m_wasPanning || !isLink || element.url.host() != m_warmedLinkUrl.host())
+        dropLinkWarmUp();
+    m_warmedLinkUrl = QUrl();
+    if (m_wasPanning || !isLink || element.url != m_linkPrefetchUrl)
+        dropLinkPrefetch();
 
     if (m_wasPanning) {
         return;     // ignore release after panning
     }
-    else if(result.linkElement().isNull()) {
+    else if (!isLink) {
 #if defined(ENABLE_LINK_SELECTION_DEBUG)
         qDebug() << "hittest NOT found" << p;
 #endif
@@ -353,20 +437,22 @@ void WebViewport::mouseReleaseEventFromChild(QGraphicsSceneMouseEvent * event)
 #if defined(ENABLE_LINK_SELECTION_DEBUG)
         qDebug() << "hittest found" << p;
 #endif
-        QPoint linkPoint = result.boundingRect().topLeft();
-        QWebFrame* frame = result.frame();
-        while (frame) {
-            linkPoint += frame->pos();
-            frame = frame->parentFrame();
-        }
         m_linkSelectionItem = new LinkSelectionItem(this);
         m_linkSelectionItem->appear(mapFromScene(m_viewportWidget->webView()->mapToScene(p)),
-                                    mapFromScene(m_viewportWidget->webView()->mapToScene(QRectF(linkPoint, result.boundingRect().size())).boundingRect()).boundingRect());
-        // delayed click
-        m_delayedMouseReleaseEvent = new QGraphicsSceneMouseEvent(event->type());
-        copyMouseEvent(event, m_delayedMouseReleaseEvent);
-        QTimer::singleShot(500, this, SLOT(startLinkSelection()));
-        return;
+                                    mapFromScene(m_viewportWidget->webView()->mapToScene(QRectF(element.rect)).boundingRect()).boundingRect());
+        // in fast tap mode the highlight animates while the link loads
+        if (!Settings::instance()->fastTapEnabled()) {
+            // delayed click
+            m_delayedMouseReleaseEvent = new QGraphicsSceneMouseEvent(event->type());
+            copyMouseEvent(event, m_delayedMouseReleaseEvent);
+            QTimer::singleShot(500, this, SLOT(startLinkSelection()));
+            // the document keeps loading into the cache while the click waits
+            m_linkPrefetchUrl = element.url;
+            Prefetcher::instance()->prefetch(m_linkPrefetchUrl);
+            return;
+        }
+        // the navigation picks up the prefetch, or it expires
+        m_linkPrefetchUrl = QUrl();
     }
 #endif
     m_selfSentEvent = event;
@@ -385,6 +471,23 @@ void WebViewport::startLinkSelection()
 
     delete m_delayedMouseReleaseEvent;
     m_delayedMouseReleaseEvent = 0;
+    // the navigation picks up the prefetch, or it expires
+    m_linkPrefetchUrl = QUrl();
+}
+
+void WebViewport::dropDelayedLinkClick()
+{
+    delete m_delayedMouseReleaseEvent;
+    m_delayedMouseReleaseEvent = 0;
+    dropLinkPrefetch();
+}
+
+void WebViewport::dropLinkPrefetch()
+{
+    if (m_linkPrefetchUrl.isEmpty())
+        return;
+    Prefetcher::instance()->cancel(m_linkPrefetchUrl);
+    m_linkPrefetchUrl = QUrl();
 }
 
 void WebViewport::wheelEvent(QGraphicsSceneWheelEvent *event)
@@ -426,6 +529,101 @@ bool WebViewport::mouseEventFromChild(QGraphicsSceneMouseEvent *event)
     return m_recognizer.filterMouseEvent(event);
 }
 
+/*!
+  Zooms the viewport by the first two touch points of \a event. Returns
+  true while a pinch is in progress and the event was consumed.
+
+  The pinch only transforms the content that is already rendered. The
+  new geometry and zoom scale are committed, and the backing store
+  renders again, when the pinch ends.
+*/
+bool WebViewport::pinchTouchEvent(QTouchEvent* event)
+{
+    QList<QTouchEvent::TouchPoint> points;
+    if (event->type() != QEvent::TouchEnd) {
+        foreach (const QTouchEvent::TouchPoint& point, event->touchPoints()) {
+            if (point.state() != Qt::TouchPointReleased)
+                points.append(point);
+        }
+    }
+
+    if (points.size() < 2) {
+        if (!m_pinchActive)
+            return false;
+        endPinch();
+        return true;
+    }
+
+    // a finger of the pinch was replaced, zoom on from where the content is now
+    if (m_pinchActive && (points.at(0).id() != m_pinchTouchIds[0] || points.at(1).id() != m_pinchTouchIds[1]))
+        m_pinchBaseGeometry = QRectF();
+
+    if (!m_pinchActive)
+        startPinch(points.at(0), points.at(1));
+    else
+        updatePinch(points.at(0), points.at(1));
+    return true;
+}
+
+void WebViewport::startPinch(const QTouchEvent::TouchPoint& first, const QTouchEvent::TouchPoint& second)
+{
+    stopPannedWidgetGeomAnim();
+
+    // mark that interaction has happened, and that the release is no tap
+    m_viewportWidget->setResizeMode(WebViewportItem::ContentResizePreservesScale);
+    m_wasPanning = true;
+    dropDelayedLinkClick();
+    dropLinkWarmUp();
+
+    m_pinchActive = true;
+    m_geomAnimStartValue = widget()->geometry();
+    m_geomAnimCurrentValue = m_geomAnimStartValue;
+    m_viewportWidget->disableContentUpdates();
+    updatePinch(first, second);
+}
+
+void WebViewport::updatePinch(const QTouchEvent::TouchPoint& first, const QTouchEvent::TouchPoint& second)
+{
+    QPointF p1 = mapFromScene(first.scenePos());
+    QPointF p2 = mapFromScene(second.scenePos());
+    QPointF center = (p1 + p2) / 2;
+    qreal distance = QLineF(p1, p2).length();
+
+    if (!m_pinchBaseGeometry.isValid() || m_pinchStartDistance <= 0) {
+        m_pinchTouchIds[0] = first.id();
+        m_pinchTouchIds[1] = second.id();
+        m_pinchBaseGeometry = m_geomAnimCurrentValue;
+        m_pinchStartCenter = center;
+        m_pinchStartDistance = distance;
+        return;
+    }
+
+    qreal scale = distance / m_pinchStartDistance;
+    qreal contentsWidth = m_viewportWidget->contentsSize().width();
+    if (contentsWidth > 0) {
+        qreal baseZoom = m_pinchBaseGeometry.width() / contentsWidth;
+        qreal minZoom = qMin(size().width() / contentsWidth, baseZoom);
+        qreal maxZoom = qMax(s_maxPinchZoomScale, baseZoom);
+        scale = qBound(minZoom, baseZoom * scale, maxZoom) / baseZoom;
+    }
+
+    // the content point under the fingers follows their center
+    QPointF topLeft = center - (m_pinchStartCenter - m_pinchBaseGeometry.topLeft()) * scale;
+    QRectF r(topLeft, m_pinchBaseGeometry.size() * scale);
+    m_geomAnimCurrentValue = r;
+    applyPannedWidgetTransform(r);
+}
+
+void WebViewport::endPinch()
+{
+    m_pinchActive = false;
+    m_pinchBaseGeometry = QRectF();
+    m_pinchStartDistance = 0;
+
+    m_geomAnimEndValue = adjustRectForPannedWidgetGeometry(m_geomAnimCurrentValue);
+    transferAnimStateToView();
+}
+
 bool WebViewport::processMaemo5ZoomKeys(QKeyEvent* event)
 {
     const bool zoomIn = event->key() == Qt::Key_F7;
@@ -465,6 +663,33 @@ void WebViewport::startZoomAnimToItemHotspot(const QPointF& hotspot, const QPoin
     startPannedWidgetGeomAnim(- newViewportOrigo, m_viewportWidget->size() * scale);
 }
 
+qreal WebViewport::zoomScale() const
+{
+    return m_viewportWidget->zoomScale();
+}
+
+/*!
+  The contents point at the top left corner of the viewport.
+*/
+QPointF WebViewport::contentsPosition() const
+{
+    return -m_viewportWidget->pos() / zoomScale();
+}
+
+/*!
+  Shows the contents at \a zoomScale with \a contentsPos at the top left
+  corner of the viewport, like contentsPosition() reported it earlier.
+*/
+void WebViewport::setZoomScaleAndContentsPosition(qreal zoomScale, const QPointF& contentsPos)
+{
+    stopPannedWidgetGeomAnim();
+
+    // mark that interaction has happened
+    m_viewportWidget->setResizeMode(WebViewportItem::ContentResizePreservesScale);
+    setPannedWidgetGeometry(QRectF(-contentsPos * zoomScale, QSizeF(m_viewportWidget->contentsSize()) * zoomScale));
+    m_viewportWidget->commitZoom();
+}
+
 bool WebViewport::isZoomedIn() const
 {
     return size().width() < m_viewportWidget->size().width();
@@ -486,16 +711,29 @@ void WebViewport::contentsSizeChangeCausedResize()
     updateViewportRange();
 }
 
-void WebViewport::webPanningStarted()
+void WebViewport::webPanningStarted(const QRectF& geometry)
 {
     m_wasPanning = true;
+    dropLinkWarmUp();
+    dropLinkPrefetch();
+    updatePanVelocity(geometry.topLeft());
 
-    // turn on and off tile creating while autoscrolling
     if (m_panningState != WebViewport::Pushing) {
         m_panningState = Pushing;
         m_backingStoreUpdateEnableTimer.stop();
-        m_viewportWidget->disableContentUpdates();
+        setBackingStoreMetricsPanning(true);
     }
+
+    // zoom animations pace the tile updates of their preview themselves
+    if (m_geomAnim.state() == QAbstractAnimation::Running)
+        return;
+
+    // tiles painted during a fast pan would be off screen before they
+    // are seen, slow pans get a few tiles painted each frame instead
+    if (isSlowPan())
+        m_viewportWidget->enableContentUpdatesWithinFrameBudget(s_maxTilePaintsPerPanFrame);
+    else
+        m_viewportWidget->disableContentUpdates();
 }
 
 void WebViewport::webPanningStopped()
@@ -503,10 +741,58 @@ void WebViewport::webPanningStopped()
     if (m_panningState != WebViewport::Inactive) {
         // m_viewportWidget->enableContentUpdates();
         m_panningState = Inactive;
-        m_backingStoreUpdateEnableTimer.start(backingStoreUpdateEnableDelay);
+        setBackingStoreMetricsPanning(false);
+        if (isSlowPan())
+            enableBackingStoreUpdates();
+        else
+            m_backingStoreUpdateEnableTimer.start(backingStoreUpdateEnableDelay);
     }
 }
 
+/*!
+  Estimates the pan velocity in px/s from consecutive viewport
+  positions. The estimate starts from the progressive update limit so
+  that the first frames of a pan are treated as fast.
+*/
+void WebViewport::updatePanVelocity(const QPointF& pos)
+{
+    if (m_panningState != WebViewport::Pushing || m_panSampleTime.isNull()) {
+        m_panVelocity = s_maxProgressiveUpdatePanVelocity;
+    } else {
+        int elapsed = m_panSampleTime.elapsed();
+        if (elapsed > 0) {
+            qreal velocity = QLineF(m_panSamplePos, pos).length() * 1000 / elapsed;
+            m_panVelocity += s_panVelocitySmoothing * (velocity - m_panVelocity);
+        }
+    }
+    m_panSamplePos = pos;
+    m_panSampleTime.start();
+}
+
+bool WebViewport::isSlowPan() const
+{
+    return Settings::instance()->progressivePanUpdatesEnabled()
+        && m_panVelocity < s_maxProgressiveUpdatePanVelocity
+        && m_geomAnim.state() != QAbstractAnimation::Running;
+}
+
+void WebViewport::setBackingStoreMetricsPanning(bool panning)
+{
+#if !USE_WEBKIT2
+    WebView* webView = m_viewportWidget->webView();
+    if (!webView)
+        return;
+    webView->backingStoreMetrics()->setPanning(panning);
+#if defined(ENABLE_PAN_UPDATE_DEBUG)
+    if (!panning)
+        qDebug() << __FUNCTION__ << "pan frames:" << webView->backingStoreMetrics()->panFrameCount()
+                 << "checkerboard:" << webView->backingStoreMetrics()->panCheckerboardRate();
+#endif
+#else
+    Q_UNUSED(panning);
+#endif
+}
+
 void WebViewport::hintHideToolbar()
 {
     emit toolbarVisibleHint(false);
@@ -593,33 +879,76 @@ void WebViewport::setPannedWidgetGeometry(const QRectF& g)
     updateViewportRange();
 }
 
+/*!
+  Animates the panned widget to \a pos and \a size by transforming the
+  content as it is currently rendered. The geometry and the zoom scale
+  of the web view are committed once, when the animation ends, so the
+  cost of an animation frame does not depend on the page.
+*/
 void WebViewport::startPannedWidgetGeomAnim(const QPointF& pos, const QSizeF& size)
 {
-    QRectF currentGeometry = widget()->geometry();
-
-    m_posAnim.setStartValue(currentGeometry.topLeft());
-    m_sizeAnim.setStartValue(currentGeometry.size());
+    // lands a running animation where it currently is
+    stopPannedWidgetGeomAnim();
 
+    m_geomAnimStartValue = widget()->geometry();
+    m_geomAnimCurrentValue = m_geomAnimStartValue;
     m_geomAnimEndValue = adjustRectForPannedWidgetGeometry(QRectF(pos, size));
 
-    m_posAnim.setEndValue(m_geomAnimEndValue.topLeft());
-    m_sizeAnim.setEndValue(m_geomAnimEndValue.size());
-
+    m_geomAnim.setStartValue(m_geomAnimStartValue);
+    m_geomAnim.setEndValue(m_geomAnimEndValue);
     m_geomAnim.start();
 }
 
+void WebViewport::setPannedWidgetAnimGeometry(const QRectF& r)
+{
+    m_geomAnimCurrentValue = r;
+    applyPannedWidgetTransform(r);
+    // the tiles of the committed scale stand in, newly uncovered ones fill in slowly
+    m_viewportWidget->enableContentUpdatesWithinFrameBudget(s_maxTilePaintsPerZoomAnimFrame);
+}
+
+/*!
+  Shows the panned widget at \a r by transforming it from the geometry
+  it had when the animation or pinch started.
+*/
+void WebViewport::applyPannedWidgetTransform(const QRectF& r)
+{
+    if (m_geomAnimStartValue.isEmpty())
+        return;
+
+    QPointF delta = r.topLeft() - m_geomAnimStartValue.topLeft();
+    m_viewportWidget->setTransform(QTransform().translate(delta.x(), delta.y())
+                                   .scale(r.width() / m_geomAnimStartValue.width(), r.height() / m_geomAnimStartValue.height()));
+}
+
 void WebViewport::stopPannedWidgetGeomAnim()
 {
     m_geomAnimEndValue = QRectF();
     m_geomAnim.stop();
+
+    // an interrupted pinch lands where it is
+    if (m_pinchActive) {
+        m_pinchActive = false;
+        m_pinchBaseGeometry = QRectF();
+        m_pinchStartDistance = 0;
+        transferAnimStateToView();
+    }
 }
 
 void WebViewport::transferAnimStateToView()
 {
-    if (m_geomAnimEndValue.isValid()) {
-        widget()->resize(m_geomAnimEndValue.size());
-        setPosition(m_geomAnimEndValue.topLeft());
-    }
+    m_viewportWidget->setTransform(QTransform());
+
+    // an interrupted animation stays where it was last shown
+    QRectF target = m_geomAnimEndValue.isValid() ? m_geomAnimEndValue : m_geomAnimCurrentValue;
+    m_geomAnimStartValue = QRectF();
+    m_geomAnimCurrentValue = QRectF();
+    if (!target.isValid())
+        return;
+
+    widget()->resize(target.size());
+    setPosition(target.topLeft());
+    m_viewportWidget->commitZoom();
 }
 
 void WebViewport::geomAnimStateChanged(QAbstractAnimation::State newState,QAbstractAnimation::State)
@@ -24,10 +24,12 @@
 #include "yberconfig.h"
 
 #include <QPropertyAnimation>
-#include <QParallelAnimationGroup>
 #include <QGraphicsSceneMouseEvent>
 #include <QGraphicsWidget>
+#include <QTime>
 #include <QTimer>
+#include <QTouchEvent>
+#include <QUrl>
 #include "PannableViewport.h"
 
 #include "CommonGestureRecognizer.h"
@@ -46,6 +48,7 @@ class QGraphicsEllipseItem;
 class WebViewport : public PannableViewport, private CommonGestureConsumer
 {
     Q_OBJECT
+    Q_PROPERTY(QRectF pannedWidgetAnimGeometry READ pannedWidgetAnimGeometry WRITE setPannedWidgetAnimGeometry)
 public:
     WebViewport(QGraphicsItem* parent = 0);
     ~WebViewport();
@@ -54,6 +57,10 @@ public:
     void setWebView(WebView* webview);
     WebViewportItem* viewportItem() const { return m_viewportWidget; }
 
+    qreal zoomScale() const;
+    QPointF contentsPosition() const;
+    void setZoomScaleAndContentsPosition(qreal zoomScale, const QPointF& contentsPos);
+
 public Q_SLOTS:
     void reset();
 
@@ -61,6 +68,7 @@ Q_SIGNALS:
     void toolbarVisibleHint(bool visible);
 
 protected:
+    bool sceneEvent(QEvent*);
     bool sceneEventFilter(QGraphicsItem*, QEvent*);
     void wheelEvent(QGraphicsSceneWheelEvent*);
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent*);
@@ -70,6 +78,7 @@ protected:
     void mouseReleaseEventFromChild(QGraphicsSceneMouseEvent * event);
     void mouseDoubleClickEventFromChild(QGraphicsSceneMouseEvent * event);
     void adjustClickPosition(QPointF& pos);
+    bool isDoubleTapPossible(const QPointF& scenePos);
     bool processMaemo5ZoomKeys(QKeyEvent* event);
 
 
@@ -82,8 +91,16 @@ protected:
  private:
     void resetZoomAnim();
     void wheelEventFromChild(QGraphicsSceneWheelEvent *event);
+    bool pinchTouchEvent(QTouchEvent* event);
+    void startPinch(const QTouchEvent::TouchPoint&, const QTouchEvent::TouchPoint&);
+    void updatePinch(const QTouchEvent::TouchPoint&, const QTouchEvent::TouchPoint&);
+    void endPinch();
     bool mouseEventFromChild(QGraphicsSceneMouseEvent *event);
     bool isZoomedIn() const;
+    void dropDelayedLinkClick();
+    void warmUpLinkAt(const QPointF& scenePos);
+    void dropLinkWarmUp();
+    void dropLinkPrefetch();
 
     enum PanningState {
         Inactive,
@@ -91,15 +108,21 @@ protected:
     };
 
     void setPannedWidgetGeometry(const QRectF& r);
+    QRectF pannedWidgetAnimGeometry() const { return m_geomAnimCurrentValue; }
+    void setPannedWidgetAnimGeometry(const QRectF& r);
+    void applyPannedWidgetTransform(const QRectF& r);
     void startPannedWidgetGeomAnim(const QPointF& pos, const QSizeF& size);
     void stopPannedWidgetGeomAnim();
     QRectF adjustRectForPannedWidgetGeometry(const QRectF&);
     void transferAnimStateToView();
     void updateViewportItemSizeIfDimensionPreserved();
     void updateViewportRange();
+    void updatePanVelocity(const QPointF& pos);
+    bool isSlowPan() const;
+    void setBackingStoreMetricsPanning(bool panning);
 
  private Q_SLOTS:
-    void webPanningStarted();
+    void webPanningStarted(const QRectF& geometry);
     void webPanningStopped();
     void hintHideToolbar();
     void geomAnimStateChanged(QAbstractAnimation::State newState, QAbstractAnimation::State);
@@ -114,13 +137,25 @@ protected:
     QTimer m_backingStoreUpdateEnableTimer;
     LinkSelectionItem* m_linkSelectionItem; 
     QGraphicsSceneMouseEvent* m_delayedMouseReleaseEvent;
+    QUrl m_linkPrefetchUrl;
+    // the link under the latest press, warmed up until the press is a tap or a pan
+    QUrl m_warmedLinkUrl;
 
-    QParallelAnimationGroup m_geomAnim;
-    QPropertyAnimation m_posAnim;
-    QPropertyAnimation m_sizeAnim;
+    QPropertyAnimation m_geomAnim;
+    QRectF m_geomAnimStartValue;
+    QRectF m_geomAnimCurrentValue;
     QRectF m_geomAnimEndValue;
 
+    bool m_pinchActive;
+    int m_pinchTouchIds[2];
+    QRectF m_pinchBaseGeometry;
+    QPointF m_pinchStartCenter;
+    qreal m_pinchStartDistance;
+
     bool m_wasPanning;
+    QTime m_panSampleTime;
+    QPointF m_panSamplePos;
+    qreal m_panVelocity;
 
 #if defined(ENABLE_LINK_SELECTION_VISUAL_DEBUG)
     QGraphicsRectItem* m_searchRectItem;
@@ -26,7 +26,10 @@
  */
 
 #include "WebViewportItem.h"
+#include "BackingStoreMetrics.h"
 #include "EventHelpers.h"
+#include "FrameClock.h"
+#include "PageGeometryCache.h"
 #include "WebView.h"
 
 #include <QGraphicsScene>
@@ -61,6 +64,21 @@ const qreal s_zoomableContentMinWidth = 300.;
 const qreal s_zoomRectAdjustHeight = 5.;
 const qreal s_zoomRectAdjustWidth = 5.;
 const qreal s_dpiAdjustmentFactor = 1.5;
+// share of a 60fps frame tile painting may take while panning
+const int s_tilePaintFrameTimeBudgetMS = 8;
+const int s_maxTilePaintsPerZoomFrame = 2;
+
+struct ContentsSizeTotals {
+    ContentsSizeTotals()
+        : received(0), applied(0)
+    {
+    }
+
+    int received;
+    int applied;
+};
+
+ContentsSizeTotals s_contentsSize;
 }
 
 /*!
@@ -80,6 +98,8 @@ WebViewportItem::WebViewportItem(QGraphicsWidget* parent, Qt::WindowFlags wFlags
     , m_zoomCommitTimer(this)
     , m_resizeMode(WebViewportItem::ContentResizePreservesWidth)
     , m_zoomPos(0, 0)
+    , m_contentsSizeChangePending(false)
+    , m_frameTilePaintBudget(0)
 {
 #if !defined(ENABLE_PAINT_DEBUG)
     setFlag(QGraphicsItem::ItemHasNoContents, true);
@@ -93,6 +113,8 @@ WebViewportItem::WebViewportItem(QGraphicsWidget* parent, Qt::WindowFlags wFlags
 
 WebViewportItem::~WebViewportItem()
 {
+    if (m_contentsSizeChangePending)
+        FrameClock::instance()->unsubscribe(this, SLOT(applyContentsSizeChange()));
 }
 
 void WebViewportItem::setWebView(WebView* webView)
@@ -129,8 +151,9 @@ void WebViewportItem::connectWebViewSignals()
     connect(m_webView->page(), SIGNAL(contentsSizeChanged(const QSize &)), this, SLOT(webViewContentsSizeChanged(const QSize&)));
 #else
     connect(m_webView->page()->mainFrame(), SIGNAL(contentsSizeChanged(const QSize &)), this, SLOT(webViewContentsSizeChanged(const QSize&)));
+    connect(m_webView->page(), SIGNAL(tilePainted(unsigned, unsigned)), this, SLOT(tilePainted(unsigned, unsigned)));
 #if QTWEBKIT_VERSION >= QTWEBKIT_VERSION_CHECK(2, 1, 0)
-    connect(m_webView->page(), SIGNAL(viewportChangeRequested(const QWebPage::ViewportAttributes&)), this, SLOT(adjustViewport(const QWebPage::ViewportHints&)));
+    connect(m_webView->page(), SIGNAL(viewportChangeRequested(const QWebPage::ViewportAttributes&)), this, SLOT(adjustViewport(const QWebPage::ViewportAttributes&)));
 #endif
 #endif
 }
@@ -142,6 +165,7 @@ void WebViewportItem::disconnectWebViewSignals()
     disconnect(m_webView->page(), SIGNAL(contentsSizeChanged(const QSize &)), this, SLOT(webViewContentsSizeChanged(const QSize&)));
 #else
     disconnect(m_webView->page()->mainFrame(), SIGNAL(contentsSizeChanged(const QSize &)), this, SLOT(webViewContentsSizeChanged(const QSize&)));
+    disconnect(m_webView->page(), SIGNAL(tilePainted(unsigned, unsigned)), this, SLOT(tilePainted(unsigned, unsigned)));
 #if QTWEBKIT_VERSION >= QTWEBKIT_VERSION_CHECK(2, 1, 0)
     disconnect(m_webView->page(), SIGNAL(viewportChangeRequested(const QWebPage::ViewportAttributes&)), this, SLOT(adjustViewport(const QWebPage::ViewportAttributes&)));
 #endif
@@ -149,28 +173,58 @@ void WebViewportItem::disconnectWebViewSignals()
 }
 
 
+/*!
+  Turns a zoom preview into the contents scale of the web view.
+*/
 void WebViewportItem::commitZoom()
 {
+    m_zoomCommitTimer.stop();
+    if (!m_webView->transform().isIdentity()) {
+        qreal scale = zoomScale();
+#if !USE_WEBKIT2
+        m_webView->prepareScaleChange();
+#endif
+        m_webView->setTransform(QTransform());
+        m_webView->setScale(scale);
+    }
 #if !USE_WEBKIT2
     m_webView->setTiledBackingStoreFrozen(false);
 #endif
-    m_zoomCommitTimer.stop();
+}
+
+/*!
+  Contents size changes come in bursts while a page loads. Only the
+  latest size of a frame is applied, on the next tick of the frame clock.
+*/
+void WebViewportItem::webViewContentsSizeChanged(const QSize& newContentsSize)
+{
+    s_contentsSize.received++;
+    m_contentSize = newContentsSize;
+    if (m_contentsSizeChangePending)
+        return;
+    m_contentsSizeChangePending = true;
+    FrameClock::instance()->subscribe(this, SLOT(applyContentsSizeChange()));
 }
 
 /*!
 \fn void WebViewportItem::contentsSizeChangeCausedResize()
 This signal is emitted when contents size has changed and vieport item is resized due to this
 */
-void WebViewportItem::webViewContentsSizeChanged(const QSize& newContentsSize)
+void WebViewportItem::applyContentsSizeChange()
 {
+    FrameClock::instance()->unsubscribe(this, SLOT(applyContentsSizeChange()));
+    m_contentsSizeChangePending = false;
+    if (!m_webView)
+        return;
+    s_contentsSize.applied++;
+
+    QSize newContentsSize = m_contentSize;
 #if USE_WEBKIT2
     m_webView->setGeometry(QRect(0, 0, newContentsSize.width(), newContentsSize.height()));
 #endif
     QSizeF currentSize = size();
     qreal targetScale = zoomScale();
 
-    m_contentSize = newContentsSize;
-
     switch(m_resizeMode) {
     case WebViewportItem::ContentResizePreservesWidth:
         targetScale = currentSize.width() / newContentsSize.width();
@@ -185,11 +239,27 @@ void WebViewportItem::webViewContentsSizeChanged(const QSize& newContentsSize)
     QSizeF scaledSize = newContentsSize * targetScale;
 
     resize(scaledSize);
+    // a scale change previewed by the resize goes in with the geometry
+    // instead of after the commit delay, unless a pan has the backing
+    // store frozen, then the commit timer takes it as before
+    bool panning = false;
+#if !USE_WEBKIT2
+    panning = m_webView->backingStoreMetrics()->isPanning();
+#endif
+    if (!m_webView->transform().isIdentity() && !panning)
+        commitZoom();
 
     // fixme: emit only when size changed (or change signal name)
     emit contentsSizeChangeCausedResize();
 }
 
+void WebViewportItem::writeSessionReport(QTextStream& stream)
+{
+    stream << "[contents size changes]" << endl;
+    stream << "received: " << s_contentsSize.received
+           << ", applied: " << s_contentsSize.applied << endl;
+}
+
 #if defined(ENABLE_PAINT_DEBUG)
 void WebViewportItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
@@ -221,6 +291,7 @@ void WebViewportItem::resizeEvent(QGraphicsSceneResizeEvent* event)
 
 void WebViewportItem::disableContentUpdates()
 {
+    m_frameTilePaintBudget = 0;
 #if !USE_WEBKIT2    
     m_webView->setTiledBackingStoreFrozen(true);
 #endif
@@ -228,6 +299,7 @@ void WebViewportItem::disableContentUpdates()
 
 void WebViewportItem::enableContentUpdates()
 {
+    m_frameTilePaintBudget = 0;
 #if !USE_WEBKIT2    
     m_webView->setTiledBackingStoreFrozen(false);
 #endif
@@ -235,6 +307,32 @@ void WebViewportItem::enableContentUpdates()
 //    m_zoomCommitTimer.start(s_zoomCommitTimerDurationMS);
 }
 
+/*!
+  Lets the backing store paint tiles until \a maxTilePaints tiles have
+  been painted or the frame time budget is used, and freezes it again
+  after that. Keeps content coming in during slow pans without letting
+  tile painting stall the frame.
+*/
+void WebViewportItem::enableContentUpdatesWithinFrameBudget(int maxTilePaints)
+{
+    m_frameTilePaintBudget = maxTilePaints;
+    m_frameBudgetStart.start();
+#if !USE_WEBKIT2
+    m_webView->setTiledBackingStoreFrozen(false);
+#endif
+}
+
+#if !USE_WEBKIT2
+void WebViewportItem::tilePainted(unsigned, unsigned)
+{
+    if (m_frameTilePaintBudget <= 0)
+        return;
+    if (--m_frameTilePaintBudget && m_frameBudgetStart.elapsed() < s_tilePaintFrameTimeBudgetMS)
+        return;
+    disableContentUpdates();
+}
+#endif
+
 #if USE_WEBKIT2
 void WebViewportItem::updatePreferredSize()
 {
@@ -305,14 +403,9 @@ void WebViewportItem::findZoomableRectForPoint(const QPointF& p)
 #else
     QPointF webp = m_webView->mapFromParent(p);
 
-    QWebHitTestResult r = m_webView->page()->mainFrame()->hitTestContent(webp.toPoint());
-    QWebElement e = r.enclosingBlockElement();
-
-    while (!e.isNull() && e.geometry().width() < s_minDoubleClickZoomTargetWidth) {
-        e = e.parent();
-    }
-    if (!e.isNull())
-        zoomRectReceived(e.geometry());
+    QRect block;
+    if (m_webView->pageGeometryCache()->findZoomableBlock(webp.toPoint(), s_minDoubleClickZoomTargetWidth, block))
+        zoomRectReceived(block);
 #endif
 }
 
@@ -321,28 +414,40 @@ qreal WebViewportItem::zoomScale() const
     if (!m_webView)
         return 1.;
 
-    return m_webView->scale();
+    // includes a zoom preview that is not committed yet
+    return m_webView->scale() * m_webView->transform().m11();
 }
 
+/*!
+  Sets the zoom scale. Unless committed instantly, the new scale is
+  first only previewed by transforming the web view. The tiles of the
+  committed scale are reused scaled, and the backing store keeps
+  filling the newly uncovered area around them at that scale, nearest
+  to the visible center first. The contents scale follows once the zoom
+  has settled.
+*/
 void WebViewportItem::setZoomScale(qreal value, bool commitInstantly)
 {
-    if (!commitInstantly) {
-        disableContentUpdates();
+    value = qBound(s_minZoomScale, value, s_maxZoomScale);
+
+    if (commitInstantly) {
+        m_webView->setTransform(QTransform());
+        if (value != m_webView->scale())
+            m_webView->setScale(value);
+        commitZoom();
+        return;
     }
 
-    value = qBound(s_minZoomScale, value, s_maxZoomScale);
-    qreal curZoomScale = zoomScale();
-    if (value != curZoomScale) {
-        // fixme
-        // QPointF p = m_webView->pos();
-        m_webView->setScale(value);
-        //p *= value / curZoomScale;
-        //setPos(p);
+    if (value != zoomScale()) {
+        qreal previewScale = value / m_webView->scale();
+        m_webView->setTransform(QTransform::fromScale(previewScale, previewScale));
+#if !USE_WEBKIT2
+        // the backing store looks at its visible area again when unfrozen
+        m_webView->setTiledBackingStoreFrozen(true);
+#endif
+        enableContentUpdatesWithinFrameBudget(s_maxTilePaintsPerZoomFrame);
     }
-    if (commitInstantly)
-        commitZoom();
-    else
-        m_zoomCommitTimer.start(s_zoomCommitTimerDurationMS);
+    m_zoomCommitTimer.start(s_zoomCommitTimerDurationMS);
 }
 
 void WebViewportItem::setResizeMode(WebViewportItem::ResizeMode mode)
@@ -31,12 +31,14 @@
 #include "yberconfig.h"
 
 #include <QGraphicsWidget>
+#include <QTime>
 #include <QTimer>
 #if !USE_WEBKIT2
 #include "qwebpage.h"
 #endif
 
 class WebView;
+class QTextStream;
 
 class WebViewportItem : public QGraphicsWidget
 {
@@ -54,6 +56,7 @@ public:
 
     void disableContentUpdates();
     void enableContentUpdates();
+    void enableContentUpdatesWithinFrameBudget(int maxTilePaints);
 
     void findZoomableRectForPoint(const QPointF&);
 
@@ -69,6 +72,8 @@ public:
     void setResizeMode(ResizeMode);
     ResizeMode resizeMode() const { return m_resizeMode; }
 
+    static void writeSessionReport(QTextStream&);
+
 public Q_SLOTS:
     void commitZoom();
 #if QTWEBKIT_VERSION >= 0x020100 && !USE_WEBKIT2
@@ -88,7 +93,11 @@ protected:
 
 protected Q_SLOTS:
     void webViewContentsSizeChanged(const QSize &size);
+    void applyContentsSizeChange();
     void zoomRectReceived(const QRect& zoomRect);
+#if !USE_WEBKIT2
+    void tilePainted(unsigned hPos, unsigned vPos);
+#endif
 
 private:
     Q_DISABLE_COPY(WebViewportItem)
@@ -103,6 +112,9 @@ private:
     ResizeMode m_resizeMode;
     QPointF m_zoomPos;
     QSize m_contentSize;
+    bool m_contentsSizeChangePending;
+    int m_frameTilePaintBudget;
+    QTime m_frameBudgetStart;
 };
 
 #endif
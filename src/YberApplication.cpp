@@ -24,6 +24,8 @@
 #include "Helpers.h"
 #include "EnvHttpProxyFactory.h"
 #include "ApplicationWindow.h"
+#include "ContentFilter.h"
+#include "DiskCache.h"
 
 #include <QUrl>
 #include <QNetworkProxyFactory>
@@ -32,6 +34,7 @@
 YberApplication::YberApplication()
     : m_appwin(0)
     , m_cookieJar(0)
+    , m_networkAccessManager(0)
 {
     bool useSystemConf = true;
 
@@ -54,6 +57,7 @@ YberApplication::YberApplication()
 
 YberApplication::~YberApplication()
 {
+    delete m_networkAccessManager;
     delete m_cookieJar;
 }
 
@@ -71,9 +75,10 @@ void YberApplication::startWithWindow(ApplicationWindow* appwin)
 
 }
 
-void YberApplication::createMainView(const QUrl& url)
+void YberApplication::createMainView(const QList<QUrl>& urls)
 {
     BrowsingView* page = new BrowsingView();
+    page->startSession(urls);
 
 #if USE_MEEGOTOUCH
     page->setAutoMarginsForComponentsEnabled(true);
@@ -85,9 +90,6 @@ void YberApplication::createMainView(const QUrl& url)
 #else
     page->appear(m_appwin);
 #endif
-
-    if (!url.isEmpty())
-        page->load(url);
 }
 
 CookieJar* YberApplication::cookieJar() const
@@ -97,6 +99,27 @@ CookieJar* YberApplication::cookieJar() const
     return m_cookieJar;
 }
 
+NetworkAccessManager* YberApplication::networkAccessManager() const
+{
+    if (!m_networkAccessManager) {
+        m_networkAccessManager = new NetworkAccessManager;
+        CookieJar* jar = cookieJar();
+        // setCookieJar changes the parent of the passed jar ;(
+        // So we need to preserve it
+        QObject* oldParent = jar->parent();
+        m_networkAccessManager->setCookieJar(jar);
+        jar->setParent(oldParent);
+        if (Settings::instance()->diskCacheSize())
+            m_networkAccessManager->setCache(new DiskCache);
+        ContentFilter* filter = new ContentFilter(m_networkAccessManager);
+        if (filter->load(Settings::instance()->contentFilterFilePath()))
+            m_networkAccessManager->setContentFilter(filter);
+        else
+            delete filter;
+    }
+    return m_networkAccessManager;
+}
+
 YberApplication* YberApplication::instance()
 {
     static YberApplication* self = 0;
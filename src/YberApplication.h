@@ -25,6 +25,10 @@
 
 #include "ApplicationWindow.h"
 #include "CookieJar.h"
+#include "NetworkAccessManager.h"
+
+#include <QList>
+#include <QUrl>
 
 class YberApplication
 {
@@ -34,11 +38,12 @@ public:
 
     void startWithWindow(ApplicationWindow*);
 
-    void createMainView(const QUrl& url);
+    void createMainView(const QList<QUrl>& urls);
 
     ApplicationWindow* activeApplicationWindow() const { return m_appwin; }
 
     CookieJar* cookieJar() const;
+    NetworkAccessManager* networkAccessManager() const;
 
     static YberApplication* instance();
 
@@ -47,6 +52,7 @@ private:
 
     ApplicationWindow *m_appwin;
     mutable CookieJar* m_cookieJar;
+    mutable NetworkAccessManager* m_networkAccessManager;
 };
 
 #endif
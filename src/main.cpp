@@ -35,6 +35,7 @@
 #include "YberApplication.h"
 #include "Settings.h"
 #include "Helpers.h"
+#include "PerformanceReport.h"
 
 #include <QDebug>
 #include <QFile>
@@ -97,6 +98,8 @@ int main(int argc, char** argv)
     Settings* settings = Settings::instance();
 
     settings->setPrivatePath(privPath);
+    // starts the session clock
+    PerformanceReport::instance();
 
     QWebSettings::setObjectCacheCapacities((16 * 1024 * 1024) / 8, (16 * 1024 * 1024) / 8, 16 * 1024 * 1024);
     QWebSettings::setMaximumPagesInCache(4);
@@ -128,6 +131,32 @@ int main(int argc, char** argv)
             } else if (args.at(1) == "-c") {
                 settings->enableTileCache(false);
                 args.removeAt(1);
+            } else if (args.at(1) == "-u") {
+                settings->enableTileStoreTuning(false);
+                args.removeAt(1);
+            } else if (args.at(1) == "-p") {
+                settings->enableProgressivePanUpdates(false);
+                args.removeAt(1);
+            } else if (args.at(1) == "-r") {
+                settings->enableInputResampling(true);
+                args.removeAt(1);
+            } else if (args.at(1) == "-rp") {
+                settings->enableInputResampling(true);
+                settings->enableInputPrediction(true);
+                args.removeAt(1);
+            } else if (args.at(1) == "-s") {
+                settings->enableFastTap(false);
+                args.removeAt(1);
+            } else if (args.at(1) == "-b") {
+                settings->enableBackgroundThrottling(false);
+                args.removeAt(1);
+            } else if (args.at(1) == "-n") {
+                settings->enablePreconnect(false);
+                args.removeAt(1);
+            } else if (args.at(1) == "-dc" && args.count() > 2) {
+                settings->setDiskCacheSize(args.at(2).toLongLong() * 1024 * 1024);
+                args.removeAt(1);
+                args.removeAt(1);
             } else if (args.at(1) == "-v") {
                 settings->enableTileVisualization(true);
                 args.removeAt(1);
@@ -148,26 +177,26 @@ int main(int argc, char** argv)
         }
     }
 
-    QString url;
-    if (args.count() > 1)
-        url = args.at(1);
-
     QWebSettings::globalSettings()->setAttribute(QWebSettings::TiledBackingStoreEnabled, settings->tileCacheEnabled());
 
 
-    YberApplication::instance()->startWithWindow(window);
-    YberApplication::instance()->createMainView(urlFromUserInput(url));
-
-    for (int i = 2; i < args.count(); i++) {
-        if (args.at(i) != "-software")
-            YberApplication::instance()->createMainView(urlFromUserInput(args.at(i)));
+    // the first url opens in the active tab, the rest load when selected
+    QList<QUrl> urls;
+    for (int i = 1; i < args.count(); i++) {
+        if (!args.at(i).isEmpty() && args.at(i) != "-software")
+            urls.append(urlFromUserInput(args.at(i)));
     }
 
+    YberApplication::instance()->startWithWindow(window);
+    YberApplication::instance()->createMainView(urls);
+
 #if QTOPIA
     window->showMaximized();
 #endif
     int retval = app->exec();
 
+    PerformanceReport::instance()->write();
+
 #if !defined(NDEBUG)
     delete app;
 #endif
@@ -177,11 +206,19 @@ int main(int argc, char** argv)
 void usage(const char* name)
 {
     QTextStream s(stderr);
-    s << "usage: " << name << " [options] url" << endl;
+    s << "usage: " << name << " [options] [url...]" << endl;
     s << " -w disable fullscreen" << endl;
     s << " -t disable toolbar" << endl;
     s << " -g use glwidget as qgv viewport" << endl;
     s << " -c disable tile cache" << endl;
+    s << " -u disable adaptive tile cache tuning" << endl;
+    s << " -p freeze tile cache while panning" << endl;
+    s << " -r resample pointer position while panning" << endl;
+    s << " -rp predict pointer position while panning" << endl;
+    s << " -s wait for double tap before dispatching link taps" << endl;
+    s << " -b run background tabs at full rate" << endl;
+    s << " -n disable host lookups, connections and prefetches ahead of loads" << endl;
+    s << " -dc <MB> disk cache size, 0 disables the disk cache" << endl;
     s << " -v enable tile visualization" << endl;
     s << " -f show fps counter" << endl;
     s << " -a disable url autocomplete" << endl;